@@ -0,0 +1,65 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+/// @file Arena.h
+/// @brief bump allocator for the plain arrays of generated geometry
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief hands out arrays from a few large blocks and frees them all at once
+ *
+ * Nothing is destroyed, so only trivially destructible types can be
+ * allocated. reset keeps the blocks, so the arena does not grow when the
+ * same feather is generated again after a reset. An Arena is not thread
+ * safe, give each thread its own.
+ */
+class Arena
+{
+public:
+    /// @param[in] _blockBytes size of each block, larger requests get a block of their own
+    explicit Arena(std::size_t _blockBytes = 1u << 20);
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&) noexcept = default;
+    Arena &operator=(Arena &&) noexcept = default;
+
+    /// @brief allocate _count default initialised values
+    template <typename T>
+    std::span<T> allocate(std::size_t _count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena never runs destructors");
+        if (_count == 0)
+            return {};
+        T *data = static_cast<T *>(allocateBytes(_count * sizeof(T), alignof(T)));
+        for (std::size_t i = 0; i < _count; ++i)
+            new (data + i) T;
+        return std::span<T>(data, _count);
+    }
+
+    /// @brief release every allocation, the blocks are kept for reuse
+    void reset() noexcept;
+    /// @brief bytes handed out since the last reset
+    std::size_t bytesUsed() const noexcept { return m_bytesUsed; }
+    /// @brief bytes held in blocks
+    std::size_t capacity() const noexcept;
+
+private:
+    void *allocateBytes(std::size_t _bytes, std::size_t _alignment);
+
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size = 0;
+    };
+    std::vector<Block> m_blocks;
+    /// @brief the block being filled and the first free byte in it
+    std::size_t m_block = 0;
+    std::size_t m_offset = 0;
+    std::size_t m_blockBytes;
+    std::size_t m_bytesUsed = 0;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BARBBATCH_H_
+#define BARBBATCH_H_
+/// @file BarbBatch.h
+/// @brief batched tessellation of many cubic curves stored in structure of arrays layout
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "BernsteinBasis.h"
+#include <cstddef>
+#include <vector>
+
+/// @brief instruction sets the batch kernel can run with
+enum class SimdLevel
+{
+    SCALAR,
+    SSE,
+    AVX2
+};
+
+/// @brief get the best instruction set supported by the running cpu (detected once)
+SimdLevel detectSimdLevel() noexcept;
+
+/// @brief get a printable name for a SimdLevel
+const char *simdLevelName(SimdLevel _level) noexcept;
+
+/**
+ * @brief control points of a set of cubic curves in structure of arrays layout
+ *
+ * Control point k of curve i lives at x[k][i], y[k][i], z[k][i] so the
+ * batch kernel can load the same control point of 4 or 8 curves at once.
+ */
+struct CubicBatch
+{
+    /// @brief resize every component array to hold _numCurves curves
+    void resize(std::size_t _numCurves);
+    /// @brief number of curves in the batch
+    std::size_t size() const noexcept { return x[0].size(); }
+    /// @brief store the 4 control points of curve _index
+    void set(std::size_t _index, const ngl::Vec3 *_cp) noexcept;
+    /// @brief read back the 4 control points of curve _index
+    void get(std::size_t _index, ngl::Vec3 *o_cp) const noexcept;
+
+    std::vector<ngl::Real> x[4];
+    std::vector<ngl::Real> y[4];
+    std::vector<ngl::Real> z[4];
+};
+
+/// @brief tessellate every curve of the batch at the uniform steps of a cubic basis table,
+/// computing the [LOD x 4] . [4 x 3N] product of weights and control points
+/// @param[in] _batch the control points of the curves
+/// @param[in] _basis a degree 3 Bernstein table, its LOD is the number of samples per curve
+/// @param[out] o_samples array of _batch.size() * LOD points, curve i is written to
+/// o_samples[i * LOD] .. o_samples[i * LOD + LOD - 1]
+/// @param[in] _level the instruction set to use, falls back to a lower one if not supported
+void evaluateCubicBatch(const CubicBatch &_batch, const BernsteinBasis &_basis, ngl::Vec3 *o_samples,
+                        SimdLevel _level = detectSimdLevel()) noexcept;
+
+/// @brief tessellate curves [_begin, _end) of the batch, the samples land at the same place
+/// in o_samples as they would for the whole batch so ranges can run on different threads
+void evaluateCubicBatch(const CubicBatch &_batch, const BernsteinBasis &_basis, std::size_t _begin, std::size_t _end,
+                        ngl::Vec3 *o_samples, SimdLevel _level = detectSimdLevel()) noexcept;
+
+#endif
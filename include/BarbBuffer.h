@@ -0,0 +1,108 @@
+#ifndef BARBBUFFER_H_
+#define BARBBUFFER_H_
+/// @file BarbBuffer.h
+/// @brief every barb of a feather stored in contiguous arrays with lightweight index views
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "BarbBatch.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// @brief which side of the rachis a barb grows on
+enum class BarbSide
+{
+    LEFT,
+    RIGHT
+};
+
+class BarbBuffer;
+
+/// @brief a view of one barb inside a BarbBuffer, only an index so it is cheap to copy,
+/// it stays valid until the buffer is resized
+class BarbView
+{
+public:
+    BarbView(const BarbBuffer &_buffer, std::size_t _index) noexcept : m_buffer(&_buffer), m_index(_index) {}
+    /// @brief index of the barb in the buffer, left barbs first then right barbs
+    std::size_t index() const noexcept { return m_index; }
+    /// @brief get control point _k (0..3) of the barb
+    ngl::Vec3 controlPoint(unsigned int _k) const noexcept;
+    /// @brief get the tessellated points of the barb
+    std::span<const ngl::Vec3> samples() const noexcept;
+
+private:
+    const BarbBuffer *m_buffer;
+    std::size_t m_index;
+};
+
+/**
+ * @brief storage for all barbs of a feather
+ *
+ * The control points of every barb live in one CubicBatch (structure of arrays)
+ * and the samples in one array of size() * lod() points. Barb i of the left side
+ * is stored at index i and barb i of the right side at numBarbs() + i, so the
+ * samples of each side form a single contiguous range and all barbs can be
+ * uploaded into one vertex buffer and drawn with a single call by FeatherRenderer.
+ */
+class BarbBuffer
+{
+public:
+    /// @brief resize for _numBarbs barbs per side with _lod samples each,
+    /// existing storage is reused when it is large enough
+    void resize(std::size_t _numBarbs, unsigned int _lod);
+    /// @brief remove every barb, keeping the allocated memory
+    void clear() noexcept;
+    /// @brief number of barbs on each side
+    std::size_t numBarbs() const noexcept { return m_numBarbs; }
+    /// @brief number of barbs on both sides
+    std::size_t size() const noexcept { return 2 * m_numBarbs; }
+    bool empty() const noexcept { return m_numBarbs == 0; }
+    /// @brief number of samples per barb
+    unsigned int lod() const noexcept { return m_lod; }
+
+    /// @brief buffer index of barb _i on _side
+    std::size_t index(BarbSide _side, std::size_t _i) const noexcept
+    {
+        return _side == BarbSide::LEFT ? _i : m_numBarbs + _i;
+    }
+    /// @brief get a view of barb _i on _side
+    BarbView barb(BarbSide _side, std::size_t _i) const noexcept { return BarbView(*this, index(_side, _i)); }
+
+    /// @brief control points of every barb, written by the generator
+    CubicBatch &controlPoints() noexcept { return m_controlPoints; }
+    const CubicBatch &controlPoints() const noexcept { return m_controlPoints; }
+    /// @brief samples of every barb, barb b owns [b * lod(), (b + 1) * lod())
+    std::span<ngl::Vec3> samples() noexcept { return m_samples; }
+    std::span<const ngl::Vec3> samples() const noexcept { return m_samples; }
+    /// @brief the contiguous samples of every barb on one side
+    std::span<const ngl::Vec3> sideSamples(BarbSide _side) const noexcept;
+
+    /// @brief first vertex of each barb's line strip, laid out for one multi draw call
+    const std::vector<std::int32_t> &drawFirsts() const noexcept { return m_drawFirsts; }
+    /// @brief vertex count of each barb's line strip, laid out for one multi draw call
+    const std::vector<std::int32_t> &drawCounts() const noexcept { return m_drawCounts; }
+
+private:
+    std::size_t m_numBarbs = 0;
+    unsigned int m_lod = 0;
+    CubicBatch m_controlPoints;
+    std::vector<ngl::Vec3> m_samples;
+    /// @brief line strip ranges of every barb, rebuilt when the layout changes
+    std::vector<std::int32_t> m_drawFirsts;
+    std::vector<std::int32_t> m_drawCounts;
+};
+
+inline ngl::Vec3 BarbView::controlPoint(unsigned int _k) const noexcept
+{
+    const CubicBatch &cp = m_buffer->controlPoints();
+    return ngl::Vec3(cp.x[_k][m_index], cp.y[_k][m_index], cp.z[_k][m_index]);
+}
+
+inline std::span<const ngl::Vec3> BarbView::samples() const noexcept
+{
+    return m_buffer->samples().subspan(m_index * m_buffer->lod(), m_buffer->lod());
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef BATCHPIPELINE_H_
+#define BATCHPIPELINE_H_
+/// @file BatchPipeline.h
+/// @brief read -> generate -> write pipeline for batches of parameter files
+#include "BoundedQueue.h"
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// @brief one feather of a batch as it reaches the sink
+struct BatchResult
+{
+    /// @brief position in the batch, results reach the sink in this order
+    std::size_t index = 0;
+    /// @brief file stem, with _k appended for variant k when there are several, unique in a batch:
+    /// a file whose stem an earlier file already has fails with an error instead
+    std::string name;
+    /// @brief the feather as OBJ text, empty when serialising is off or on error
+    std::string obj;
+    /// @brief why the feather failed, empty on success
+    std::string error;
+};
+
+/// @brief called on the writer thread for every result in batch order,
+/// returning false counts the feather as failed
+using BatchSink = std::function<bool(const BatchResult &)>;
+
+struct BatchSettings
+{
+    /// @brief generation threads, 0 for one per core
+    unsigned int workers = 0;
+    /// @brief items each queue between stages holds, 0 for twice the workers
+    std::size_t queueCapacity = 0;
+    /// @brief feathers per parameter file, variant k adds k to the file's seed
+    unsigned int variants = 1;
+    /// @brief build the OBJ text on the workers, off to measure generation alone
+    bool serialise = true;
+    /// @brief also write the outlines and template barbs
+    bool outlines = true;
+};
+
+/// @brief where a stage's threads spent the run
+struct StageStats
+{
+    unsigned int threads = 0;
+    std::size_t items = 0;
+    /// @brief time spent working, summed over the threads, queue waits excluded
+    double busyMs = 0.0;
+    /// @brief busyMs as a share of the threads' run time, 1 means the stage never waited
+    double occupancy = 0.0;
+};
+
+struct BatchStats
+{
+    StageStats read;
+    StageStats generate;
+    StageStats write;
+    /// @brief parsed jobs waiting for a worker
+    QueueStats parsedQueue;
+    /// @brief generated feathers waiting for the writer
+    QueueStats generatedQueue;
+    /// @brief the most feathers between reading and writing at once, the bound on memory
+    std::size_t maxInFlight = 0;
+    std::size_t feathers = 0;
+    std::size_t failed = 0;
+    std::size_t objBytes = 0;
+    double wallMs = 0.0;
+
+    double feathersPerSecond() const noexcept { return wallMs > 0.0 ? 1000.0 * feathers / wallMs : 0.0; }
+    /// @brief one line per stage and queue plus a total, for printing
+    std::vector<std::string> lines() const;
+};
+
+/**
+ * @brief generate every feather of a batch with file reads, generation and writes overlapping
+ *
+ * One reader thread loads and parses the parameter files, a pool of workers
+ * each applies them to its own Feather with setParams and generates it, and
+ * the calling thread hands the results to _sink in batch order. The stages
+ * talk through BoundedQueues, a full queue stalls the stage feeding it, and
+ * the reader also waits while maxInFlight feathers are between reading and
+ * writing, so the reorder buffer in front of the sink stays bounded too. Peak
+ * memory depends on the settings, not on the number of files.
+ * @param[in] _files the parameter files, see readFeatherParams
+ * @param[in] _settings threads, queue sizes and output options
+ * @param[in] _sink receives every feather in order, failed ones with their error set
+ * @return per stage and per queue statistics of the run
+ * @throw whatever _sink throws, rethrown once the other stages have stopped, errors while
+ * reading or generating a feather fail only that feather
+ */
+BatchStats runBatchPipeline(const std::vector<std::filesystem::path> &_files, const BatchSettings &_settings,
+                            const BatchSink &_sink);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BERNSTEINBASIS_H_
+#define BERNSTEINBASIS_H_
+/// @file BernsteinBasis.h
+/// @brief table of Bernstein weights for uniform tessellation at a fixed degree and LOD
+#include "ngl/Types.h"
+#include <vector>
+
+/**
+ * @brief [LOD x (degree+1)] matrix of Bernstein weights
+ *
+ * Row s holds the weights of every control point at t = s / LOD. All barbs of
+ * a feather share the same degree and LOD, so the table is built once and
+ * tessellating a set of curves becomes the product of this matrix with the
+ * [(degree+1) x 3N] matrix of their control point coordinates.
+ */
+class BernsteinBasis
+{
+public:
+    BernsteinBasis() = default;
+    /// @brief build the table for the given degree and LOD
+    BernsteinBasis(unsigned int _degree, unsigned int _lod);
+    /// @brief rebuild the table for the given degree and LOD
+    void rebuild(unsigned int _degree, unsigned int _lod);
+    /// @brief whether the table was built for this degree and LOD
+    bool matches(unsigned int _degree, unsigned int _lod) const noexcept
+    {
+        return !m_weights.empty() && m_degree == _degree && m_lod == _lod;
+    }
+    unsigned int degree() const noexcept { return m_degree; }
+    unsigned int lod() const noexcept { return m_lod; }
+    /// @brief the degree+1 weights of sample _s
+    const ngl::Real *row(unsigned int _s) const noexcept { return &m_weights[_s * (m_degree + 1)]; }
+
+private:
+    unsigned int m_degree = 0;
+    unsigned int m_lod = 0;
+    /// @brief row major weights, degree+1 per sample
+    std::vector<ngl::Real> m_weights;
+};
+
+#endif
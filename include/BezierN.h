@@ -0,0 +1,154 @@
+#ifndef BEZIERN_H_
+#define BEZIERN_H_
+/// @file BezierN.h
+/// @brief Bezier evaluation kernels specialised on the degree of the curve at compile time
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include <array>
+#include <cstddef>
+
+/// @brief degree specialised Bezier evaluation
+/// the generic version is a fully unrolled deCasteljau on a fixed size stack array,
+/// the cubic version (used by every curve of the feather) evaluates the Bernstein
+/// weights once and blends the four control points with them
+template <unsigned int Degree>
+struct BezierN
+{
+	/// @brief the number of control points a curve of this degree has
+	static constexpr std::size_t numCPs = Degree + 1;
+
+	/// @brief evaluate the curve at _t
+	/// @param[in] _cp pointer to numCPs control points
+	/// @param[in] _t the value between 0 and 1 to evaluate the point
+	static ngl::Vec3 evaluate(const ngl::Vec3 *_cp, ngl::Real _t) noexcept
+	{
+		std::array<ngl::Vec3, numCPs> pts;
+		for (std::size_t i = 0; i < numCPs; ++i)
+			pts[i] = _cp[i];
+		const ngl::Real mt = 1.0f - _t;
+		for (std::size_t n = Degree; n > 0; --n) {
+			for (std::size_t i = 0; i < n; ++i) {
+				pts[i].m_x = mt * pts[i].m_x + _t * pts[i + 1].m_x;
+				pts[i].m_y = mt * pts[i].m_y + _t * pts[i + 1].m_y;
+				pts[i].m_z = mt * pts[i].m_z + _t * pts[i + 1].m_z;
+			}
+		}
+		return pts[0];
+	}
+};
+
+/// @brief cubic fast path using the Bernstein basis
+template <>
+struct BezierN<3>
+{
+	static constexpr std::size_t numCPs = 4;
+
+	/// @brief compute the four cubic Bernstein weights for _t
+	/// @param[in] _t the value between 0 and 1
+	/// @param[out] o_w the weights of p0..p3
+	static void weights(ngl::Real _t, ngl::Real o_w[4]) noexcept
+	{
+		const ngl::Real mt = 1.0f - _t;
+		const ngl::Real mt2 = mt * mt;
+		const ngl::Real t2 = _t * _t;
+		o_w[0] = mt2 * mt;
+		o_w[1] = 3.0f * mt2 * _t;
+		o_w[2] = 3.0f * mt * t2;
+		o_w[3] = t2 * _t;
+	}
+
+	/// @brief blend four control points with precomputed weights
+	static ngl::Vec3 blend(const ngl::Vec3 *_cp, const ngl::Real _w[4]) noexcept
+	{
+		return ngl::Vec3(
+			_w[0] * _cp[0].m_x + _w[1] * _cp[1].m_x + _w[2] * _cp[2].m_x + _w[3] * _cp[3].m_x,
+			_w[0] * _cp[0].m_y + _w[1] * _cp[1].m_y + _w[2] * _cp[2].m_y + _w[3] * _cp[3].m_y,
+			_w[0] * _cp[0].m_z + _w[1] * _cp[1].m_z + _w[2] * _cp[2].m_z + _w[3] * _cp[3].m_z);
+	}
+
+	/// @brief evaluate the cubic at _t
+	/// @param[in] _cp pointer to the 4 control points
+	/// @param[in] _t the value between 0 and 1 to evaluate the point
+	static ngl::Vec3 evaluate(const ngl::Vec3 *_cp, ngl::Real _t) noexcept
+	{
+		ngl::Real w[4];
+		weights(_t, w);
+		return blend(_cp, w);
+	}
+
+	/// @brief evaluate the first derivative of the cubic at _t
+	/// @param[in] _cp pointer to the 4 control points
+	/// @param[in] _t the value between 0 and 1
+	static ngl::Vec3 derivative(const ngl::Vec3 *_cp, ngl::Real _t) noexcept
+	{
+		// 3 * quadratic Bezier of the control point differences
+		const ngl::Real mt = 1.0f - _t;
+		const ngl::Real w0 = 3.0f * mt * mt;
+		const ngl::Real w1 = 6.0f * mt * _t;
+		const ngl::Real w2 = 3.0f * _t * _t;
+		return (_cp[1] - _cp[0]) * w0 + (_cp[2] - _cp[1]) * w1 + (_cp[3] - _cp[2]) * w2;
+	}
+
+	/// @brief evaluate position, first and second derivative of the cubic at _t in one pass,
+	/// the derivatives fall out of the intermediate deCasteljau levels
+	/// @param[in] _cp pointer to the 4 control points
+	/// @param[in] _t the value between 0 and 1
+	/// @param[out] o_pos the point on the curve
+	/// @param[out] o_d1 the first derivative
+	/// @param[out] o_d2 the second derivative
+	static void evaluateWithDerivatives(const ngl::Vec3 *_cp, ngl::Real _t, ngl::Vec3 &o_pos,
+	                                    ngl::Vec3 &o_d1, ngl::Vec3 &o_d2) noexcept
+	{
+		const ngl::Real mt = 1.0f - _t;
+		const ngl::Vec3 q0 = _cp[0] * mt + _cp[1] * _t;
+		const ngl::Vec3 q1 = _cp[1] * mt + _cp[2] * _t;
+		const ngl::Vec3 q2 = _cp[2] * mt + _cp[3] * _t;
+		const ngl::Vec3 r0 = q0 * mt + q1 * _t;
+		const ngl::Vec3 r1 = q1 * mt + q2 * _t;
+		o_pos = r0 * mt + r1 * _t;
+		o_d1 = (r1 - r0) * 3.0f;
+		o_d2 = (q2 - q1 * 2.0f + q0) * 6.0f;
+	}
+
+	/// @brief tessellate the cubic at _count uniform steps t = i * _step using forward differencing
+	/// each sample costs three vector adds, every _reanchor samples the differences are
+	/// recomputed from the exact polynomial to stop float drift accumulating (0 never re-anchors)
+	/// @param[in] _cp pointer to the 4 control points
+	/// @param[in] _step the parameter step between samples
+	/// @param[in] _count the number of samples to write
+	/// @param[out] o_pts array of at least _count points
+	/// @param[in] _reanchor the number of samples between exact re-evaluations
+	static void sampleUniform(const ngl::Vec3 *_cp, ngl::Real _step, std::size_t _count,
+	                          ngl::Vec3 *o_pts, std::size_t _reanchor = 0) noexcept
+	{
+		// power basis P(t) = a t^3 + b t^2 + c t + d
+		const ngl::Vec3 a = _cp[3] - _cp[0] + (_cp[1] - _cp[2]) * 3.0f;
+		const ngl::Vec3 b = (_cp[0] - _cp[1] * 2.0f + _cp[2]) * 3.0f;
+		const ngl::Vec3 c = (_cp[1] - _cp[0]) * 3.0f;
+		const ngl::Vec3 &d = _cp[0];
+		const ngl::Real h = _step;
+		const ngl::Real h2 = h * h;
+		const ngl::Real h3 = h2 * h;
+		const ngl::Vec3 d3 = a * (6.0f * h3);
+
+		ngl::Vec3 f, d1, d2;
+		auto anchor = [&](ngl::Real _t)
+		{
+			f = ((a * _t + b) * _t + c) * _t + d;
+			d1 = a * (3.0f * _t * _t * h + 3.0f * _t * h2 + h3) + b * (2.0f * _t * h + h2) + c * h;
+			d2 = a * (6.0f * _t * h2 + 6.0f * h3) + b * (2.0f * h2);
+		};
+
+		anchor(0.0f);
+		for (std::size_t i = 0; i < _count; ++i) {
+			if (_reanchor != 0 && i != 0 && i % _reanchor == 0)
+				anchor(static_cast<ngl::Real>(i) * h);
+			o_pts[i] = f;
+			f += d1;
+			d1 += d2;
+			d2 += d3;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+/// @file BoundedQueue.h
+/// @brief blocking fixed capacity queue between pipeline stages, with occupancy statistics
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/// @brief how full a BoundedQueue was and how long its producers and consumers waited
+struct QueueStats
+{
+    std::size_t capacity = 0;
+    std::size_t pushes = 0;
+    std::size_t maxSize = 0;
+    /// @brief time weighted mean number of items queued
+    double meanSize = 0.0;
+    /// @brief total time producers waited on a full queue, the backpressure
+    double pushWaitMs = 0.0;
+    /// @brief total time consumers waited on an empty queue
+    double popWaitMs = 0.0;
+};
+
+/**
+ * @brief a FIFO that blocks producers while it is full and consumers while it is empty
+ *
+ * close ends the stream: push then fails and pop returns false once the queue
+ * has drained. Every method is thread safe.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t _capacity) : m_capacity(_capacity > 0 ? _capacity : 1) {}
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /// @brief add an item, waiting for space
+    /// @return false if the queue was closed, the item is dropped
+    bool push(T _item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_items.size() >= m_capacity && !m_closed)
+        {
+            const auto start = Clock::now();
+            m_notFull.wait(lock, [this]() { return m_items.size() < m_capacity || m_closed; });
+            m_pushWait += Clock::now() - start;
+        }
+        if (m_closed)
+        {
+            return false;
+        }
+        accumulate();
+        m_items.push_back(std::move(_item));
+        ++m_pushes;
+        m_maxSize = std::max(m_maxSize, m_items.size());
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /// @brief take the oldest item, waiting for one
+    /// @return false once the queue is closed and empty
+    bool pop(T &o_item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_items.empty() && !m_closed)
+        {
+            const auto start = Clock::now();
+            m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+            m_popWait += Clock::now() - start;
+        }
+        if (m_items.empty())
+        {
+            return false;
+        }
+        accumulate();
+        o_item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /// @brief no more pushes, waiting producers and consumers are released
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    /// @brief the statistics since construction
+    QueueStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        QueueStats stats;
+        stats.capacity = m_capacity;
+        stats.pushes = m_pushes;
+        stats.maxSize = m_maxSize;
+        const auto now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - m_created).count();
+        const double sizeSeconds = m_sizeSeconds + static_cast<double>(m_items.size()) *
+                                   std::chrono::duration<double>(now - m_lastChange).count();
+        stats.meanSize = elapsed > 0.0 ? sizeSeconds / elapsed : 0.0;
+        stats.pushWaitMs = std::chrono::duration<double, std::milli>(m_pushWait).count();
+        stats.popWaitMs = std::chrono::duration<double, std::milli>(m_popWait).count();
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief add the time spent at the current size, call with the lock held before the size changes
+    void accumulate() noexcept
+    {
+        const auto now = Clock::now();
+        m_sizeSeconds += static_cast<double>(m_items.size()) * std::chrono::duration<double>(now - m_lastChange).count();
+        m_lastChange = now;
+    }
+
+    const std::size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    bool m_closed = false;
+
+    std::size_t m_pushes = 0;
+    std::size_t m_maxSize = 0;
+    const Clock::time_point m_created = Clock::now();
+    Clock::time_point m_lastChange = m_created;
+    /// @brief integral of the size over time
+    double m_sizeSeconds = 0.0;
+    Clock::duration m_pushWait{};
+    Clock::duration m_popWait{};
+};
+
+#endif
@@ -6,16 +6,39 @@
 #ifndef CURVE_H_
 #define CURVE_H_
 /// @file Curve.h
-/// @brief basic BezierCurve using deCasteljau algorithm
+/// @brief basic BezierCurve using deCasteljau algorithm, CPU only, CurveVAO draws it
 // must include types.h first for Real and GLEW if required
 #include "ngl/Types.h"
 #include "ngl/Vec3.h"
 #include <vector>
-#include "ngl/VAOFactory.h"
-#include "ngl/SimpleVAO.h"
-#include "ngl/ShaderLib.h"
+#include <span>
 
 
+/// @brief a point on a curve with its first and second derivatives
+struct CurveSample
+{
+	ngl::Vec3 position;
+	ngl::Vec3 d1;
+	ngl::Vec3 d2;
+};
+
+/// @brief an orthonormal frame attached to a point of a curve
+struct CurveFrame
+{
+	ngl::Vec3 position;
+	ngl::Vec3 tangent;
+	ngl::Vec3 normal;
+	ngl::Vec3 binormal;
+};
+
+/// @brief how a BezierCurve chooses its sample points
+enum class TessellationMode
+{
+	/// @brief m_lod samples at uniform parameter steps
+	UNIFORM,
+	/// @brief subdivide until every segment is within the chordal error tolerance
+	ADAPTIVE
+};
 
 class BezierCurve
 {
@@ -30,16 +53,35 @@ public :
 	BezierCurve(const BezierCurve &_c) =delete;
 	/// @brief destructor
 	~BezierCurve() noexcept;
-	/// @brief Draw method to draw the curve 
-		void draw() noexcept;
-	/// @brief draw the control points
-	void drawControlPoints() const noexcept;
-	/// @brief Draw the control hull
-	void drawHull() const noexcept;
   	/// @brief get a point on the curve in the range of 0 - 1 based on the control points
   	/// @param[in] _value the point to evaluate between 0 and 1
   	/// @returns the value of the point at t
 	ngl::Vec3 getPointOnCurve(ngl::Real _value) noexcept;
+	/// @brief evaluate the curve at many parameters in one call without allocating
+	/// @param[in] _ts the parameters to evaluate, each between 0 and 1
+	/// @param[out] o_points receives the point of each parameter, must be at least as long as _ts
+	void evaluate(std::span<const ngl::Real> _ts, std::span<ngl::Vec3> o_points) const noexcept;
+	/// @brief evaluate positions together with first and second derivatives in one pass
+	/// @param[in] _ts the parameters to evaluate, each between 0 and 1
+	/// @param[out] o_samples receives the sample of each parameter, must be at least as long as _ts
+	void evaluateWithDerivatives(std::span<const ngl::Real> _ts, std::span<CurveSample> o_samples) const noexcept;
+	/// @brief build rotation minimising frames at the uniform LOD parameters t = i / LOD
+	/// using the double reflection method, the first normal follows the curvature
+	/// @param[out] o_frames receives LOD frames, resized as needed
+	void getSampleFrames(std::vector<CurveFrame> &o_frames) const noexcept;
+	/// @brief get the first derivative (tangent scaled by speed) of the curve at _value
+	/// @param[in] _value the point to evaluate between 0 and 1
+	ngl::Vec3 getDerivative(ngl::Real _value) noexcept;
+	/// @brief get the total arc length of the curve
+	/// @note the arc length table is built on first use after the curve changes
+	ngl::Real getLength() noexcept;
+	/// @brief get the arc length from the start of the curve to _value
+	/// @param[in] _value the parameter between 0 and 1
+	ngl::Real getLengthAtParameter(ngl::Real _value) noexcept;
+	/// @brief get the parameter at which the arc length from the start reaches _length,
+	/// found by binary search of the arc length table and Newton refinement
+	/// @param[in] _length distance along the curve, clamped to [0, getLength()]
+	ngl::Real getParameterAtLength(ngl::Real _length) noexcept;
 	/// @brief add a control point to the Curve
 	/// @param[in] &_p the point to add
 	void addPoint(const ngl::Vec3 &_p) noexcept;
@@ -48,29 +90,63 @@ public :
 	/// @param[in] _y y value of point
 	/// @param[in] _z z value of point
 	void addPoint(ngl::Real _x, ngl::Real _y, ngl::Real _z) noexcept;
+	/// @brief replace every control point, the storage is kept so rebuilding a curve
+	/// of the same degree does not allocate
+	/// @param[in] _cp the new control points
+	void setControlPoints(std::span<const ngl::Vec3> _cp) noexcept;
 	///@brief caculate the point interpolated by two points
 	///@param[in] _t the value betwween 0 and to evaluate the point
 	///@param[in] p0 the first point to interpolate
 	///@param[in] p1 the second point to interpolate
-	ngl::Vec3 lerp(ngl::Real _t, ngl::Vec3& p0, ngl::Vec3& p1) noexcept;
+	static ngl::Vec3 lerp(ngl::Real _t, const ngl::Vec3& p0, const ngl::Vec3& p1) noexcept;
 	///@brief the baisc function to caculate the point on curve
-	///this is a recursion function but have not worked well
 	///@param[in] _t the value betwween 0 and to evaluate the point
-	///@param[in] _n the degree of the Beizier curve to draw
 	///@param[in] p_list array container include all control points
 	ngl::Vec3 deCasteljau(ngl::Real _t, std::vector<ngl::Vec3>& p_list) noexcept;
+	///@brief iterative, allocation free deCasteljau evaluation
+	///curves with up to s_maxStackCPs control points are reduced in a stack buffer,
+	///higher degrees fall back to a per thread scratch buffer that is reused between calls
+	///@param[in] _t the value betwween 0 and to evaluate the point
+	///@param[in] _cp pointer to the first control point
+	///@param[in] _numCP the number of control points
+	static ngl::Vec3 deCasteljau(ngl::Real _t, const ngl::Vec3 *_cp, size_t _numCP) noexcept;
+	/// @brief the largest number of control points evaluated in the stack buffer
+	static constexpr size_t s_maxStackCPs = 16;
   	/// @brief set the Level of Detail for Drawing
   	/// @note this will have no Effect if the createVAO has
   	/// been called before
   	/// @param[in] _lod the level of detail to use when creating the VAO for drawing the higher the number
   	/// the finer the drawing
 	void setLOD(unsigned int lod) noexcept;
-  	/// @brief create and set all VAOs for a Bezier Curve
-  	void createVAO() noexcept;
+	/// @brief choose between uniform LOD sampling and adaptive flatness driven subdivision
+	/// @param[in] _mode the tessellation mode to use
+	void setTessellationMode(TessellationMode _mode) noexcept;
+	/// @brief set the maximum chordal error allowed by the adaptive mode
+	/// @param[in] _tolerance the largest allowed distance between curve and polyline
+	void setTolerance(ngl::Real _tolerance) noexcept;
+	/// @brief get the number of vertices getSamplePoints emits with the current settings,
+	/// use this to size buffers before uploading
+	size_t getVertexCount() noexcept;
+	/// @brief set how often the forward differencing sampler of cubic curves
+	/// re-evaluates the exact curve to bound float drift
+	/// @param[in] _interval number of samples between re-anchors, 0 disables re-anchoring
+	void setReanchorInterval(unsigned int _interval) noexcept;
 	///	@brief get all samples of drawing the curve and reset m_samplePts variable
+	/// @note this returns a copy, use getSampleView or appendSamplePoints in hot paths
 	std::vector<ngl::Vec3> getSamplePoints() noexcept;
+	/// @brief get a read only view of the samples without copying them
+	/// @note the view is invalidated by any call that changes the curve or its LOD
+	std::span<const ngl::Vec3> getSampleView() noexcept;
+	/// @brief append the samples of the curve to the end of a caller owned buffer
+	/// @param[in,out] io_buffer the buffer to append to, no allocation happens if it has capacity
+	void appendSamplePoints(std::vector<ngl::Vec3> &io_buffer);
+	/// @brief supply samples computed elsewhere (e.g. by the batch kernel) instead of
+	/// evaluating them here, the LOD becomes the number of samples given
+	/// @param[in] _pts pointer to the first sample
+	/// @param[in] _numPts the number of samples
+	void setSamplePoints(const ngl::Vec3 *_pts, size_t _numPts) noexcept;
 	/// @brief Get the control points of the curve
-	std::vector<ngl::Vec3> getCPs() const { return m_cp; }
+	const std::vector<ngl::Vec3> &getCPs() const noexcept { return m_cp; }
 
 
 protected :
@@ -82,14 +158,30 @@ protected :
   std::vector <ngl::Vec3> m_cp;
   /// @brief The level of detail used to calculate how much detail to draw
   unsigned int m_lod=30;
+  /// @brief how the sample points are chosen
+  TessellationMode m_tessellationMode=TessellationMode::UNIFORM;
+  /// @brief maximum chordal error of the adaptive mode
+  ngl::Real m_tolerance=0.01f;
+  /// @brief deepest subdivision the adaptive mode will go to (2^16 segments)
+  static constexpr unsigned int s_maxAdaptiveDepth = 16;
+  /// @brief recompute m_samplePts with the current tessellation mode
+  void updateSamplePoints() noexcept;
+  /// @brief append the adaptive tessellation of the curve to m_samplePts, excluding its first point
+  void subdivideAdaptive(const ngl::Vec3 *_cp, size_t _numCP, unsigned int _depth) noexcept;
+  /// @brief cumulative arc length at t = i / (size - 1), one entry per LOD step plus the end
+  std::vector<ngl::Real> m_arcLengths;
+  /// @brief control when rebuild m_arcLengths
+  bool m_arcLengthsDirty = true;
+  /// @brief rebuild the arc length table
+  void buildArcLengthTable() noexcept;
+  /// @brief integrate the speed of the curve between _t0 and _t1
+  ngl::Real integrateSpeed(ngl::Real _t0, ngl::Real _t1) noexcept;
+  /// @brief number of forward differenced samples between exact re-evaluations
+  unsigned int m_reanchorInterval=32;
   /// @brief store all samples of drawing the curve
   std::vector<ngl::Vec3> m_samplePts;
   /// @brief control when recalculate m_samplePts	
   bool m_samplePtsDirty = true;
-	/// @brief a vertex array object for our curve drawing
-	std::unique_ptr<ngl::AbstractVAO> m_vaoCurve;
-	/// @brief a vertex array object for our point drawing
-	std::unique_ptr<ngl::AbstractVAO> m_vaoPoints;
 }; // end class BezierCurve
 #endif // end header file
 
@@ -0,0 +1,54 @@
+#ifndef CURVEVAO_H_
+#define CURVEVAO_H_
+/// @file CurveVAO.h
+/// @brief the GL side of a BezierCurve, persistent VAOs for its control points and samples
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "ngl/AbstractVAO.h"
+#include <cstddef>
+#include <memory>
+#include <span>
+
+class BezierCurve;
+
+/**
+ * @brief draws a curve from points uploaded by the GL thread
+ *
+ * The VAOs are created on the first upload and kept for the lifetime of the
+ * object, later uploads stream the new points into the existing buffers.
+ */
+class CurveVAO
+{
+public:
+    CurveVAO() = default;
+    ~CurveVAO() noexcept;
+    CurveVAO(const CurveVAO &) = delete;
+    CurveVAO &operator=(const CurveVAO &) = delete;
+
+    /// @brief upload the control points and samples of a curve
+    void upload(BezierCurve &_curve) noexcept;
+    /// @brief upload control points and samples, an empty samples span clears the curve
+    void upload(std::span<const ngl::Vec3> _cps, std::span<const ngl::Vec3> _samples) noexcept;
+    /// @brief whether there is anything to draw
+    bool empty() const noexcept { return m_numSamples == 0; }
+
+    /// @brief draw the curve as a line strip
+    void draw() const noexcept;
+    /// @brief draw the control points in red
+    void drawControlPoints() const noexcept;
+    /// @brief draw the control hull
+    void drawHull() const noexcept;
+
+private:
+    /// @brief a vertex array object for our curve drawing
+    std::unique_ptr<ngl::AbstractVAO> m_vaoCurve;
+    /// @brief a vertex array object for our point drawing
+    std::unique_ptr<ngl::AbstractVAO> m_vaoPoints;
+    /// @brief number of points the buffers of m_vaoCurve and m_vaoPoints can hold
+    std::size_t m_curveCapacity = 0;
+    std::size_t m_pointsCapacity = 0;
+    std::size_t m_numSamples = 0;
+    std::size_t m_numPoints = 0;
+};
+
+#endif
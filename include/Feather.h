@@ -2,11 +2,35 @@
 #define FEATHER_H_
 
 #include "ngl/Vec3.h"
-#include <ngl/Text.h>
 #include <vector>
 #include <memory>
 #include "Curve.h"
+#include "BarbBatch.h"
+#include "BarbBuffer.h"
+#include "FeatherParams.h"
+#include "FeatherGeometry.h"
 #include <algorithm>
+#include <cstdint>
+
+/// @brief generation stages of Feather::generate
+/// rachis -> outlines -> template barbs, and rachis -> outlines -> all barbs
+enum class FeatherStage : unsigned int
+{
+    RACHIS = 1u << 0,
+    OUTLINES = 1u << 1,
+    TEMPLATE_BARBS = 1u << 2,
+    ALL_BARBS = 1u << 3
+};
+
+/// @brief wall clock milliseconds spent in each stage by the last Feather::generate,
+/// stages that were not dirty report 0
+struct FeatherStageTimes
+{
+    double rachisMs = 0.0;
+    double outlinesMs = 0.0;
+    double templateBarbsMs = 0.0;
+    double allBarbsMs = 0.0;
+};
 
 /**
  * @brief Feather class for generating procedural feather geometry
@@ -35,7 +59,7 @@ public:
     /// @param p2 Second control point  
     /// @param p3 End point
     void GenerateRachis(const ngl::Vec3& p0, const ngl::Vec3& p1, 
-                       const ngl::Vec3& p2, const ngl::Vec3& p3) const;
+                       const ngl::Vec3& p2, const ngl::Vec3& p3);
     
     /// @brief Set the sample number (LOD) for rachis curve
     /// @param num Number of samples
@@ -75,6 +99,24 @@ public:
                                                    ngl::Real p2YFactor,
                                                    bool isLeftSide = true) const;
     
+    /// @brief Compute the 4 control points of a barb between two points
+    /// @param p0 Starting point (on rachis)
+    /// @param p3 End point (on outline)
+    /// @param p1XFactor Slider value (0-1) to control p1 X position
+    /// @param p1YFactor Slider value (0-1) to control p1 Y position
+    /// @param p2XFactor Slider value (0-1) to control p2 X position
+    /// @param p2YFactor Slider value (0-1) to control p2 Y position
+    /// @param isLeftSide true for left barb, false for right barb
+    /// @param o_cp Output array receiving p0, p1, p2, p3
+    void computeBarbControlPoints(const ngl::Vec3& p0,
+                                  const ngl::Vec3& p3,
+                                  ngl::Real p1XFactor,
+                                  ngl::Real p1YFactor,
+                                  ngl::Real p2XFactor,
+                                  ngl::Real p2YFactor,
+                                  bool isLeftSide,
+                                  ngl::Vec3 o_cp[4]) const noexcept;
+
     /// @brief Set the Fb factor (barb extreme shape control)
     /// @param fb Factor controlling barb shape extremes
     void setFb(const ngl::Real _fb) noexcept;
@@ -84,7 +126,7 @@ public:
     void setBarbLOD(unsigned int lod);
     
     /// @brief Generate template barbs (left and right) and store in m_leftBarb and m_rightBarb
-    void generateTemplateBarbs() const;
+    void generateTemplateBarbs();
 
     /// @brief set outline mapping point position
     /// @param start (0.0-1.0)
@@ -92,7 +134,51 @@ public:
     void setOutlineMappingRange(ngl::Real start, ngl::Real end) noexcept;
 
     /// @brief Generate all barbs distributed along the feather length
-    void generateAllBarbs() const;
+    void generateAllBarbs();
+
+    /// @brief Set the number of threads used to generate barbs
+    /// @param numThreads thread count, 0 uses every core OpenMP reports
+    void setNumThreads(unsigned int numThreads) noexcept;
+
+    /// @brief Get the barbs built by the last generateAllBarbs, in rachis order on each side
+    const BarbBuffer& getBarbs() const noexcept { return m_barbs; }
+
+    /// @brief Get the shape factors shared by every barb, as used by the instanced path
+    BarbShape getBarbShape() const noexcept;
+
+    /// @brief Get views of every generated sample in the layout generateFeather returns,
+    /// valid until the next generate
+    FeatherGeometry getGeometry() const;
+
+    /// @brief Get the roots of the barbs on the rachis from the last generateAllBarbs
+    const std::vector<ngl::Vec3>& getBarbRoots() const noexcept { return m_barbRoots; }
+
+    /// @brief Get the tips of the barbs on one outline from the last generateAllBarbs
+    const std::vector<ngl::Vec3>& getBarbTips(BarbSide side) const noexcept
+    {
+        return side == BarbSide::LEFT ? m_barbLeftTips : m_barbRightTips;
+    }
+
+    /// @brief Set how barbs are distributed along the rachis
+    /// @param spacing PARAMETRIC (default) or ARC_LENGTH
+    void setBarbSpacing(BarbSpacing spacing) noexcept;
+
+    /// @brief Get how barbs are distributed along the rachis
+    BarbSpacing getBarbSpacing() const noexcept { return m_barbSpacing; }
+
+    /// @brief Push each barb away from its even spacing by a seeded random amount
+    /// @param jitter fraction (0-1) of half the gap to the next barb, 0 for exact spacing
+    /// @param seed picks the offsets, the same seed gives the same barbs
+    void setBarbJitter(ngl::Real jitter, std::uint32_t seed) noexcept;
+
+    /// @brief Compute the rachis and outline parameters of every barb root and tip
+    /// @note requires the rachis and outlines to have been generated
+    /// @param o_tRachis receives m_numBarbs parameters on the rachis
+    /// @param o_tLeftOutline receives m_numBarbs parameters on the left outline
+    /// @param o_tRightOutline receives m_numBarbs parameters on the right outline
+    void computeBarbParameters(std::vector<ngl::Real>& o_tRachis,
+                               std::vector<ngl::Real>& o_tLeftOutline,
+                               std::vector<ngl::Real>& o_tRightOutline) const;
     
     /// @brief Set barb control factors
     /// @param p1XFactor Slider value (0-1) to control p1 X position
@@ -112,7 +198,7 @@ public:
     void generateOutlines();
     /// @brief Set whether outlines should be symmetrical
     /// @param symmetric true for symmetrical outlines, false for separate control
-    void setOutlineSymmetric(bool symmetric) { m_outlineSymmetric = symmetric; }
+    void setOutlineSymmetric(bool symmetric);
     
     /// @brief Set whether to show outlines in full feather view
     /// @param show true to show outlines, false to hide them
@@ -138,16 +224,32 @@ public:
     /// @param p3 End point (shared by both sides)
     void setSymmetricOutlineControlPoints(const ngl::Vec3 &p1, const ngl::Vec3 &p2, const ngl::Vec3 &p3);
 
+    /// @brief Get rotation minimising frames along the sampled rachis, one per rachis sample,
+    /// used to orient barbs and build shaded geometry
+    /// @param o_frames receives the frames, none before the first generate
+    void getRachisFrames(std::vector<CurveFrame>& o_frames) const;
+
     /// get coordinate of start point of outlines
     ngl::Vec3 getStartPointOnRachis(ngl::Real _t);
     
-    /// @brief Draw functions
-    void drawRachis() const;
-    void drawOutlines() const;
-    void drawBarb() const;
-    void drawAllBarbs() const;
-    void draw() const;
-    void drawFullFeather(bool showOutlines = true) const;
+    /// @brief Get whether outlines are shown in the full feather view
+    bool getShowOutlines() const noexcept { return m_showOutlines; }
+
+    // ===== Generated Geometry =====
+    /// @brief Get the rachis curve, null before the first generate
+    BezierCurve* getRachis() const noexcept { return m_rachis.get(); }
+
+    /// @brief Get one outline curve, null before the first generate
+    BezierCurve* getOutline(BarbSide side) const noexcept
+    {
+        return side == BarbSide::LEFT ? m_leftOutline.get() : m_rightOutline.get();
+    }
+
+    /// @brief Get one template barb, null before the first generate
+    BezierCurve* getTemplateBarb(BarbSide side) const noexcept
+    {
+        return side == BarbSide::LEFT ? m_leftBarb.get() : m_rightBarb.get();
+    }
     
     // ===== UI Control Methods =====
     /// @brief Set rachis control points for UI control
@@ -164,20 +266,57 @@ public:
 
     // ===== Internal Methods =====
     /// @brief Generate rachis using current control points
-    void generateRachis() const;
-    void update();
+    void generateRachis();
+
+    /// @brief Regenerate the CPU geometry of every dirty stage and its dependents,
+    /// does no GL work so it can run on any thread, FeatherRenderer uploads the result
+    /// @return bit mask of the FeatherStage values that were rebuilt
+    unsigned int generate();
+
+    /// @brief Get the time each stage took in the last generate
+    const FeatherStageTimes& getStageTimes() const noexcept { return m_stageTimes; }
+
+    /// @brief Get a snapshot of every parameter
+    FeatherParams getParams() const;
+
+    /// @brief Apply every parameter of a snapshot through the setters,
+    /// only the stages whose parameters really changed are marked dirty
+    void setParams(const FeatherParams& params);
+
+    /// @brief Get the stages that differ between the geometry of two parameter sets
+    static unsigned int changedStages(const FeatherParams& from, const FeatherParams& to);
+
+    /// @brief Mark a stage and every stage depending on it for regeneration
+    void markDirty(FeatherStage stage) noexcept;
+
+    /// @brief Whether a stage will be regenerated by the next update
+    bool isStageDirty(FeatherStage stage) const noexcept;
+
+    /// @brief Get the bit mask of FeatherStage values waiting for regeneration
+    unsigned int getDirtyStages() const noexcept { return m_dirtyStages; }
 
 private:
     /// ====================Core Curve Components===================
-    mutable std::unique_ptr<BezierCurve> m_rachis;
-    mutable std::unique_ptr<BezierCurve> m_leftOutline;
-    mutable std::unique_ptr<BezierCurve> m_rightOutline;
-    mutable std::unique_ptr<BezierCurve> m_leftBarb;
-    mutable std::unique_ptr<BezierCurve> m_rightBarb;
+    /// @brief created by the first generate, later generations rebuild them in place
+    std::unique_ptr<BezierCurve> m_rachis;
+    std::unique_ptr<BezierCurve> m_leftOutline;
+    std::unique_ptr<BezierCurve> m_rightOutline;
+    std::unique_ptr<BezierCurve> m_leftBarb;
+    std::unique_ptr<BezierCurve> m_rightBarb;
     
     /// ====================Full Feather Barb Collections===================
-    mutable std::vector<std::unique_ptr<BezierCurve>> m_leftBarbs;
-    mutable std::vector<std::unique_ptr<BezierCurve>> m_rightBarbs;
+    /// @brief control points and samples of every barb in contiguous arrays
+    BarbBuffer m_barbs;
+    /// @brief rachis and outline parameters of every barb, reused between updates
+    std::vector<ngl::Real> m_barbTRachis;
+    std::vector<ngl::Real> m_barbTLeftOutline;
+    std::vector<ngl::Real> m_barbTRightOutline;
+    /// @brief barb roots on the rachis and tips on each outline, reused between updates
+    std::vector<ngl::Vec3> m_barbRoots;
+    std::vector<ngl::Vec3> m_barbLeftTips;
+    std::vector<ngl::Vec3> m_barbRightTips;
+    /// @brief Bernstein weights shared by every barb, degree 3 at m_numBarbules samples
+    BernsteinBasis m_barbBasis;
     /// ====================Feather Parameters===================
     /// @brief the LOD of rachies curve
     unsigned int m_sample=200;
@@ -187,6 +326,11 @@ private:
     ngl::Real m_F0=0.25f;
     /// @brief factor determining where barbs end on Rachies
     ngl::Real m_Fn=0.99f;
+    /// @brief how barbs are distributed along the rachis
+    BarbSpacing m_barbSpacing=BarbSpacing::PARAMETRIC;
+    /// @brief seeded offsets of the barbs from their even spacing
+    ngl::Real m_barbJitter=0.0f;
+    std::uint32_t m_seed=0;
     /// @brief whether outlines should be symmetrical
     bool m_outlineSymmetric=true;
     /// @brief whether to show outlines in full feather view
@@ -232,9 +376,21 @@ private:
     ngl::Vec3 m_rightOutlineP1 = ngl::Vec3(0.6f, 2.75f, 0.0f);
     ngl::Vec3 m_rightOutlineP2 = ngl::Vec3(0.5f, 10.0f, 0.0f);
     
+    /// ====================Update Tracking===================
+    /// @brief FeatherStage bits waiting for regeneration, everything starts dirty
+    unsigned int m_dirtyStages = 0xFu;
+    /// @brief measured by generate
+    FeatherStageTimes m_stageTimes;
+
+    /// ====================Threading===================
+    /// @brief threads used for barb generation, 0 means OpenMP's default
+    unsigned int m_numThreads = 0;
+
     /// ====================Helper Methods===================
     /// @brief Ensure rachis curve exists
-    void ensureRachisExists() const;
+    void ensureRachisExists();
+    /// @brief Number of threads barb generation will run on
+    int threadCount() const noexcept;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef FEATHERGENERATOR_H_
+#define FEATHERGENERATOR_H_
+/// @file FeatherGenerator.h
+/// @brief builds feather geometry on a worker thread from posted parameter snapshots
+#include "Feather.h"
+#include "FeatherParams.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/// @brief how FeatherGenerator previews a feather while its parameters are being edited
+struct ProgressiveSettings
+{
+    /// @brief off builds every snapshot at full detail straight away
+    bool enabled = false;
+    /// @brief time the preview barbs may take, measured against the last generation
+    double budgetMs = 8.0;
+    /// @brief fractions of the barb count and LOD to refine through, ascending,
+    /// full detail is appended if the last step is below 1
+    std::vector<float> steps = {0.25f, 0.5f, 1.0f};
+    /// @brief how long no snapshot has to arrive before refinement starts
+    std::chrono::milliseconds settleTime{150};
+};
+
+/**
+ * @brief generation service with a double buffered result
+ *
+ * The UI posts FeatherParams snapshots, the worker applies the newest one to
+ * its back Feather and generates it, then swaps it with the ready slot. A
+ * snapshot posted while another is still waiting replaces it, so the worker
+ * only ever builds the latest request. The GL thread takes the ready Feather
+ * with takeResult, which hands its previous front back to the worker so the
+ * buffers of both feathers are reused and only dirty stages are regenerated.
+ *
+ * With progressive settings enabled a snapshot is first built at the
+ * largest refinement step whose barbs fit the time budget, then, once no
+ * new snapshot has arrived for the settle time, at each following step up
+ * to full detail. Every step is published as its own result and a new
+ * snapshot abandons the remaining steps.
+ */
+class FeatherGenerator
+{
+public:
+    FeatherGenerator();
+    ~FeatherGenerator();
+    FeatherGenerator(const FeatherGenerator &) = delete;
+    FeatherGenerator &operator=(const FeatherGenerator &) = delete;
+
+    /// @brief queue a parameter snapshot, replaces any snapshot that has not been started yet
+    void post(const FeatherParams &_params);
+    /// @brief swap the newest generated feather into _front
+    /// @param[in,out] io_front receives the new feather, its old value is reused by the worker
+    /// @return false if nothing was generated since the last call, io_front is untouched
+    bool takeResult(std::unique_ptr<Feather> &io_front);
+    /// @brief block until every posted snapshot has been generated
+    void wait();
+    /// @brief set a callback run on the worker thread after each result is ready
+    void setOnReady(std::function<void()> _onReady);
+    /// @brief number of snapshots replaced before the worker started them
+    std::size_t droppedRequests() const;
+    /// @brief set the threads each generation uses, 0 uses every core OpenMP reports
+    void setNumThreads(unsigned int _numThreads);
+    /// @brief set the preview budget and refinement schedule, used from the next snapshot
+    void setProgressive(const ProgressiveSettings &_settings);
+
+    /// @brief scale the barb count and LOD of a snapshot, at least 1 barb and 2 samples
+    static FeatherParams scaleDetail(const FeatherParams &_params, float _detail);
+
+private:
+    void run();
+    /// @brief index of the step the preview of a snapshot is built at
+    std::size_t previewStep(const FeatherParams &_params) const;
+    /// @brief build a snapshot into m_back and publish it, called and returns with the lock held
+    void generateStep(std::unique_lock<std::mutex> &io_lock, const FeatherParams &_params, float _detail);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    /// @brief the newest snapshot the worker has not started
+    std::optional<FeatherParams> m_pending;
+    /// @brief feather the worker generates into, only touched by the worker while m_busy
+    std::unique_ptr<Feather> m_back;
+    /// @brief last generated feather waiting for takeResult
+    std::unique_ptr<Feather> m_ready;
+    bool m_hasResult = false;
+    bool m_busy = false;
+    bool m_quit = false;
+    std::size_t m_dropped = 0;
+    unsigned int m_numThreads = 0;
+    ProgressiveSettings m_progressive;
+    /// @brief measured milliseconds per barb sample, 0 until the first generation
+    double m_msPerSample = 0.0;
+    std::function<void()> m_onReady;
+    std::thread m_worker;
+};
+
+#endif
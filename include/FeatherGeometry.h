@@ -0,0 +1,130 @@
+#ifndef FEATHERGEOMETRY_H_
+#define FEATHERGEOMETRY_H_
+/// @file FeatherGeometry.h
+/// @brief reentrant feather generation from a FeatherParams into an Arena
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "Arena.h"
+#include "BarbBuffer.h"
+#include "FeatherParams.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+class BezierCurve;
+class BernsteinBasis;
+
+/// @brief barbs generated together, which barbs share a batch kernel pass depends on it
+inline constexpr std::size_t s_barbChunkSize = 64;
+
+/**
+ * @brief every sample of one generated feather
+ *
+ * The spans point into the Arena passed to generateFeather and stay valid
+ * until it is reset. The barb samples use the BarbBuffer layout, left barb i
+ * is barb i and right barb i is barb numBarbs + i, each owning barbLOD samples.
+ */
+struct FeatherGeometry
+{
+    std::span<const ngl::Vec3> rachis;
+    std::span<const ngl::Vec3> leftOutline;
+    std::span<const ngl::Vec3> rightOutline;
+    std::span<const ngl::Vec3> leftTemplateBarb;
+    std::span<const ngl::Vec3> rightTemplateBarb;
+    /// @brief barb roots on the rachis, shared by both sides
+    std::span<const ngl::Vec3> barbRoots;
+    std::span<const ngl::Vec3> leftBarbTips;
+    std::span<const ngl::Vec3> rightBarbTips;
+    std::span<const ngl::Vec3> barbSamples;
+    std::size_t numBarbs = 0;
+    unsigned int barbLOD = 0;
+
+    /// @brief the samples of barb _i on _side
+    std::span<const ngl::Vec3> barb(BarbSide _side, std::size_t _i) const noexcept
+    {
+        const std::size_t index = _side == BarbSide::LEFT ? _i : numBarbs + _i;
+        return barbSamples.subspan(index * barbLOD, barbLOD);
+    }
+};
+
+/// @brief generate a whole feather without touching anything but _params and io_arena
+/// @param[in] _params the feather to build, the same params and seed always give the same samples
+/// @param[in,out] io_arena receives every array of the result, one arena per thread
+/// @return views of the samples, equal to what Feather::generate builds from the same params
+/// @note the working curves are kept per thread, so once a thread has built a feather
+/// no smaller than _params, a reset arena makes the call allocation free
+FeatherGeometry generateFeather(const FeatherParams &_params, Arena &io_arena);
+
+/// @brief the control points of a barb from its root and tip
+/// @param[in] _p0 the root on the rachis
+/// @param[in] _p3 the tip on an outline
+/// @param[in] _shape the factors shared by every barb
+/// @param[in] _isLeftSide left barbs bend the other way in x
+/// @param[out] o_cp the 4 control points
+void barbControlPoints(const ngl::Vec3 &_p0, const ngl::Vec3 &_p3, const BarbShape &_shape, bool _isLeftSide,
+                       ngl::Vec3 o_cp[4]) noexcept;
+
+/// @brief the control points of both outlines, they start on the rachis at f0
+/// @param[in] _params the outline points and f0
+/// @param[in] _rachisSamples the tessellated rachis, must not be empty
+/// @param[out] o_left the 4 control points of the left outline
+/// @param[out] o_right the 4 control points of the right outline
+void outlineControlPoints(const FeatherParams &_params, std::span<const ngl::Vec3> _rachisSamples,
+                          ngl::Vec3 o_left[4], ngl::Vec3 o_right[4]) noexcept;
+
+/// @brief the LOD of both outlines, the share of the rachis samples past f0
+unsigned int outlineLOD(const FeatherParams &_params) noexcept;
+
+/// @brief the rachis and outline parameters of every barb root and tip
+/// @param[in] _params spacing, barb range, outline mapping and jitter
+/// @param[in] _rachis,_leftOutline,_rightOutline the generated curves, their
+/// arc length tables are built here for ARC_LENGTH spacing
+/// @param[out] o_tRachis,o_tLeftOutline,o_tRightOutline _params.numBarbs parameters each
+/// @param[in] _numThreads OpenMP threads for the ARC_LENGTH lookups
+void barbParameters(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                    BezierCurve &_rightOutline, std::span<ngl::Real> o_tRachis,
+                    std::span<ngl::Real> o_tLeftOutline, std::span<ngl::Real> o_tRightOutline,
+                    int _numThreads = 1);
+
+/// @brief where buildBarbs writes, every span holds numBarbs entries except samples,
+/// which holds 2 * numBarbs * barbLOD in the BarbBuffer layout
+struct BarbTargets
+{
+    std::span<ngl::Real> tRachis;
+    std::span<ngl::Real> tLeftOutline;
+    std::span<ngl::Real> tRightOutline;
+    std::span<ngl::Vec3> roots;
+    std::span<ngl::Vec3> leftTips;
+    std::span<ngl::Vec3> rightTips;
+    std::span<ngl::Vec3> samples;
+};
+
+// The stages below are shared by Feather and generateFeather. Each one rebuilds
+// the curves it is given in place, so reused curves keep their storage.
+
+/// @brief rebuild the rachis from the rachis points and sampleNum
+void buildRachis(const FeatherParams &_params, BezierCurve &o_rachis) noexcept;
+
+/// @brief rebuild both outlines, they start on the rachis at f0
+/// @return false when the rachis has no samples, the outlines are left untouched
+bool buildOutlines(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &o_leftOutline,
+                   BezierCurve &o_rightOutline) noexcept;
+
+/// @brief rebuild both template barbs, rooted in the middle of the barb region
+void buildTemplateBarbs(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                        BezierCurve &_rightOutline, BezierCurve &o_leftBarb, BezierCurve &o_rightBarb) noexcept;
+
+/// @brief parameters, roots, tips, control points and samples of every barb, in chunks
+/// of s_barbChunkSize so the result does not depend on the thread count
+/// @param[in] _basis the cubic basis at _params.barbLOD
+/// @param[in,out] io_controlPoints at least 2 * numBarbs wide, left barb i at i and right barb i at numBarbs + i
+/// @param[out] o_barbs sized for _params
+/// @param[in] _numThreads OpenMP threads sharing the chunks
+void buildBarbs(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                BezierCurve &_rightOutline, const BernsteinBasis &_basis, CubicBatch &io_controlPoints,
+                const BarbTargets &o_barbs, int _numThreads = 1);
+
+/// @brief the jitter of barb _i for _seed, uniform in [-1, 1)
+ngl::Real barbJitterSample(std::uint32_t _seed, std::size_t _i) noexcept;
+
+#endif
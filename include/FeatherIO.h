@@ -0,0 +1,45 @@
+#ifndef FEATHERIO_H_
+#define FEATHERIO_H_
+/// @file FeatherIO.h
+/// @brief text parameter files and OBJ output for batch feather generation
+#include "FeatherGeometry.h"
+#include "FeatherParams.h"
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+
+/**
+ * @brief read a parameter file into o_params
+ *
+ * One `key = value` per line with the FeatherParams field names as keys,
+ * `#` starts a comment. Vectors are three numbers separated by spaces or
+ * commas, barbSpacing is `parametric` or `arc_length` and booleans are
+ * `true`/`false` or `1`/`0`. Keys that are not in the file keep the value
+ * o_params already has, so start from FeatherParams() for the UI defaults.
+ * The result is then checked with validateFeatherParams.
+ * @param[in] _in the text to parse
+ * @param[in,out] o_params receives every key found
+ * @param[out] o_error set to "line N: ..." when parsing fails, for a value out of
+ * range N is the line of the offending key
+ * @return false on an unknown key, a malformed value or values validateFeatherParams rejects
+ */
+bool readFeatherParams(std::istream &_in, FeatherParams &o_params, std::string &o_error);
+/// @brief check that every field is within the range of the MainWindow control that sets it:
+/// counts up to 10000, factors and the outline mapping within [0, 1] and the barb end factors
+/// within [0.4, 1]. Anything the UI can make is accepted, no barbs or f0 == fn included.
+/// @param[out] o_error names the first field that is out of range
+bool validateFeatherParams(const FeatherParams &_params, std::string &o_error);
+/// @brief readFeatherParams from a file, o_error also reports a file that cannot be opened
+bool loadFeatherParams(const std::filesystem::path &_path, FeatherParams &o_params, std::string &o_error);
+/// @brief write every field in the format readFeatherParams reads, values round trip exactly
+void writeFeatherParams(std::ostream &_out, const FeatherParams &_params);
+
+/// @brief write the feather as OBJ polylines, one `o` object per component and one `l` per curve,
+/// curves of fewer than 2 samples cannot be polylines and are left out
+/// @param[in] _out the stream to write to, best opened in binary mode
+/// @param[in] _geometry the feather to write
+/// @param[in] _outlines also write the outlines and template barbs
+/// @return the number of vertices written
+std::size_t writeFeatherObj(std::ostream &_out, const FeatherGeometry &_geometry, bool _outlines = true);
+
+#endif
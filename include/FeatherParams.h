@@ -0,0 +1,92 @@
+#ifndef FEATHERPARAMS_H_
+#define FEATHERPARAMS_H_
+/// @file FeatherParams.h
+/// @brief a snapshot of every parameter that shapes a feather
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include <cstdint>
+
+/// @brief how barbs are distributed between F0 and Fn along the rachis
+enum class BarbSpacing
+{
+    /// @brief uniform steps of the rachis Bezier parameter
+    PARAMETRIC,
+    /// @brief uniform steps of distance along the rachis and outlines
+    ARC_LENGTH
+};
+
+/// @brief the factors shared by every barb, the same ones Feather::computeBarbControlPoints uses
+struct BarbShape
+{
+    ngl::Real fb = 0.5f;
+    ngl::Real p1XFactor = 0.3f;
+    ngl::Real p1YFactor = 1.0f;
+    ngl::Real p2XFactor = 0.1f;
+    ngl::Real p2YFactor = 0.0f;
+    /// @brief samples per barb, sample s is at t = s / lod like the CPU tessellation
+    unsigned int lod = 20;
+};
+
+/**
+ * @brief plain copyable values of every Feather parameter
+ *
+ * The UI fills one of these and hands it to the generation thread, which
+ * applies it to its own Feather with Feather::setParams. The defaults are
+ * the ones a new Feather starts with. Nothing in it refers to shared state,
+ * so one set of values can be handed to generateFeather on many threads,
+ * varying only the seed.
+ */
+struct FeatherParams
+{
+    /// @brief rachis control points and LOD
+    ngl::Vec3 rachisP0 = ngl::Vec3(0.0f, 0.0f, 0.0f);
+    ngl::Vec3 rachisP1 = ngl::Vec3(0.3f, 2.0f, 0.0f);
+    ngl::Vec3 rachisP2 = ngl::Vec3(0.5f, 4.0f, 0.0f);
+    ngl::Vec3 rachisP3 = ngl::Vec3(0.2f, 9.5f, 0.0f);
+    unsigned int sampleNum = 200;
+
+    /// @brief outline control points, the right ones are only used when not symmetric
+    bool outlineSymmetric = true;
+    ngl::Vec3 outlineP1 = ngl::Vec3(-1.8f, 3.5f, 0.0f);
+    ngl::Vec3 outlineP2 = ngl::Vec3(-1.5f, 5.5f, 0.0f);
+    ngl::Vec3 outlineP3 = ngl::Vec3(-0.2f, 9.5f, 0.0f);
+    ngl::Vec3 rightOutlineP1 = ngl::Vec3(0.6f, 2.75f, 0.0f);
+    ngl::Vec3 rightOutlineP2 = ngl::Vec3(0.5f, 10.0f, 0.0f);
+    /// @brief where the outlines start and the barbs end on the rachis
+    ngl::Real f0 = 0.25f;
+    ngl::Real fn = 0.99f;
+
+    /// @brief barb distribution
+    unsigned int numBarbs = 100;
+    unsigned int barbLOD = 20;
+    BarbSpacing barbSpacing = BarbSpacing::PARAMETRIC;
+    ngl::Real outlineMappingStart = 0.0f;
+    ngl::Real outlineMappingEnd = 1.0f;
+
+    /// @brief barb shape
+    ngl::Real fb = 0.5f;
+    ngl::Real p1XFactor = 0.3f;
+    ngl::Real p1YFactor = 1.0f;
+    ngl::Real p2XFactor = 0.1f;
+    ngl::Real p2YFactor = 0.0f;
+    /// @brief template barb tips on the outlines
+    ngl::Real leftBarbOutlineFactor = 0.55f;
+    ngl::Real rightBarbOutlineFactor = 0.51f;
+
+    /// @brief how far each barb is pushed along the rachis from its even spacing,
+    /// as a fraction of half the gap to its neighbour, 0 keeps the spacing exact
+    ngl::Real barbJitter = 0.0f;
+    /// @brief picks the jitter of each barb, the same seed gives the same feather
+    std::uint32_t seed = 0;
+
+    /// @brief display only, does not change the geometry
+    bool showOutlines = true;
+
+    /// @brief the factors shared by every barb
+    BarbShape barbShape() const noexcept
+    {
+        return BarbShape{fb, p1XFactor, p1YFactor, p2XFactor, p2YFactor, barbLOD};
+    }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef FEATHERRENDERER_H_
+#define FEATHERRENDERER_H_
+/// @file FeatherRenderer.h
+/// @brief GL resources and draw calls for the geometry of a Feather
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "ngl/Mat4.h"
+#include "ngl/AbstractVAO.h"
+#include "CurveVAO.h"
+#include "InstancedBarbs.h"
+#include <memory>
+#include <vector>
+
+class Feather;
+
+/// @brief how FeatherRenderer puts the barbs on screen
+enum class BarbRenderMode
+{
+    /// @brief upload the CPU tessellated samples of every barb
+    TESSELLATED,
+    /// @brief upload only each barb's endpoints and evaluate the cubic in the vertex shader
+    INSTANCED
+};
+
+/**
+ * @brief owns every GL object used to draw a feather
+ *
+ * Feather only builds CPU geometry, this class copies the stages that changed
+ * into persistent buffers and draws them. It lives on the GL thread while the
+ * Feather it uploads from may have been generated on any thread, after upload
+ * returns the Feather is not referenced again.
+ */
+class FeatherRenderer
+{
+public:
+    /// @brief upload the geometry of some stages of a generated feather
+    /// @param[in] _feather the feather to copy from, generate must have been called
+    /// @param[in] _stages bit mask of FeatherStage values to upload
+    void upload(const Feather &_feather, unsigned int _stages);
+
+    /// @brief Set how barbs are drawn, INSTANCED falls back to TESSELLATED if its shader fails to build,
+    /// the barbs are uploaded again by the next upload call
+    void setBarbRenderMode(BarbRenderMode _mode) noexcept;
+    /// @brief Get how barbs are drawn
+    BarbRenderMode getBarbRenderMode() const noexcept { return m_barbRenderMode; }
+    /// @brief Set the model view projection matrix used by the instanced barb shader
+    void setMVP(const ngl::Mat4 &_mvp) noexcept { m_mvp = _mvp; }
+
+    /// @brief Draw functions
+    void drawRachis() const;
+    void drawOutlines() const;
+    void drawBarb() const;
+    void drawAllBarbs() const;
+    void draw() const;
+
+private:
+    void uploadBarbs(const Feather &_feather);
+
+    CurveVAO m_rachis;
+    CurveVAO m_leftOutline;
+    CurveVAO m_rightOutline;
+    CurveVAO m_leftBarb;
+    CurveVAO m_rightBarb;
+    /// @brief samples of every barb in one buffer, drawn with glMultiDrawArrays
+    std::unique_ptr<ngl::AbstractVAO> m_barbVAO;
+    std::size_t m_barbCapacity = 0;
+    std::vector<GLint> m_barbFirsts;
+    std::vector<GLsizei> m_barbCounts;
+    std::size_t m_barbVertices = 0;
+    /// @brief endpoints of every barb for the instanced render path
+    InstancedBarbs m_instancedBarbs;
+    BarbRenderMode m_barbRenderMode = BarbRenderMode::TESSELLATED;
+    /// @brief set when the barbs have to be uploaded again for a new render mode
+    bool m_barbRenderModeChanged = false;
+    ngl::Mat4 m_mvp;
+    bool m_showOutlines = true;
+};
+
+#endif
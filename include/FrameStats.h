@@ -0,0 +1,78 @@
+#ifndef FRAMESTATS_H_
+#define FRAMESTATS_H_
+/// @file FrameStats.h
+/// @brief rolling averages of where frame and generation time goes, shown by the NGLScene overlay
+#include "Feather.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief mean of the last window values added
+class RollingAverage
+{
+public:
+    explicit RollingAverage(std::size_t _window = 60);
+    /// @brief add a value, dropping the oldest once the window is full
+    void add(double _value) noexcept;
+    /// @brief the mean of the values in the window, 0 before the first add
+    double value() const noexcept { return m_count == 0 ? 0.0 : m_sum / static_cast<double>(m_count); }
+    /// @brief number of values in the window
+    std::size_t count() const noexcept { return m_count; }
+
+private:
+    std::vector<double> m_values;
+    std::size_t m_next = 0;
+    std::size_t m_count = 0;
+    double m_sum = 0.0;
+};
+
+/**
+ * @brief per frame and per generation measurements averaged over a window
+ *
+ * Generation times are added once per feather taken from the generator, the
+ * other values once per frame, so the two are averaged over their own windows.
+ */
+class FrameStats
+{
+public:
+    explicit FrameStats(std::size_t _window = 60);
+
+    /// @brief add the stage times of a newly generated feather
+    void addGeneration(const FeatherStageTimes &_times) noexcept;
+    /// @brief add the GL work of one frame
+    /// @param[in] _uploadBytes bytes written to GL buffers
+    /// @param[in] _uploadMs CPU time spent uploading
+    /// @param[in] _drawCalls draw calls issued for the feather
+    /// @param[in] _vertices vertices those calls drew
+    void addFrame(std::size_t _uploadBytes, double _uploadMs, std::size_t _drawCalls, std::size_t _vertices) noexcept;
+    /// @brief add a GPU time read back from a timer query
+    void addGpuTime(double _ms) noexcept { m_gpuMs.add(_ms); }
+    /// @brief add the time the overlay itself took to draw
+    void addOverlayTime(double _ms) noexcept { m_overlayMs.add(_ms); }
+
+    /// @brief averaged generation time of one stage
+    double stageMs(FeatherStage _stage) const noexcept;
+    double uploadBytes() const noexcept { return m_uploadBytes.value(); }
+    double uploadMs() const noexcept { return m_uploadMs.value(); }
+    double drawCalls() const noexcept { return m_drawCalls.value(); }
+    double vertices() const noexcept { return m_vertices.value(); }
+    double gpuMs() const noexcept { return m_gpuMs.value(); }
+    double overlayMs() const noexcept { return m_overlayMs.value(); }
+
+    /// @brief one line of text per measurement for the overlay
+    std::vector<std::string> lines() const;
+
+private:
+    RollingAverage m_rachisMs;
+    RollingAverage m_outlinesMs;
+    RollingAverage m_templateBarbsMs;
+    RollingAverage m_allBarbsMs;
+    RollingAverage m_uploadBytes;
+    RollingAverage m_uploadMs;
+    RollingAverage m_drawCalls;
+    RollingAverage m_vertices;
+    RollingAverage m_gpuMs;
+    RollingAverage m_overlayMs;
+};
+
+#endif
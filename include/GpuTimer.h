@@ -0,0 +1,42 @@
+#ifndef GPUTIMER_H_
+#define GPUTIMER_H_
+/// @file GpuTimer.h
+/// @brief GL_TIME_ELAPSED queries read back without stalling the pipeline
+#include "ngl/Types.h"
+#include <cstddef>
+
+/**
+ * @brief times GPU work between begin and end
+ *
+ * Queries are kept in a small ring and only read once the driver reports them
+ * available, so a result arrives a few frames late but the CPU never waits.
+ * A frame that finds every query still in flight is simply not timed.
+ * All methods need a current OpenGL context.
+ */
+class GpuTimer
+{
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    /// @brief start timing the commands that follow
+    void begin();
+    /// @brief stop timing, must follow begin
+    void end();
+    /// @brief read the newest finished measurement
+    /// @param[out] o_ms GPU milliseconds, untouched when nothing has finished
+    /// @return whether a measurement finished since the last poll
+    bool poll(double &o_ms);
+
+private:
+    static constexpr std::size_t s_numQueries = 4;
+    GLuint m_queries[s_numQueries] = {};
+    /// @brief queries ended and queries read back, both only increase
+    std::size_t m_issued = 0;
+    std::size_t m_read = 0;
+    bool m_active = false;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef INSTANCEDBARBS_H_
+#define INSTANCEDBARBS_H_
+/// @file InstancedBarbs.h
+/// @brief draws every barb as an instance of one cubic evaluated in the vertex shader
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "ngl/Mat4.h"
+#include "FeatherParams.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/**
+ * @brief instanced render path for barbs
+ *
+ * Each barb only uploads its root p0 and tip p3 (24 bytes). The vertex shader
+ * rebuilds p1 and p2 from the shared BarbShape and evaluates the cubic at
+ * gl_VertexID / lod, left barbs are instances [0, numBarbs) and right barbs
+ * [numBarbs, 2 * numBarbs). The CPU tessellation in BarbBuffer stays the reference.
+ * All methods need a current OpenGL 4.1 context.
+ */
+class InstancedBarbs
+{
+public:
+    InstancedBarbs() = default;
+    ~InstancedBarbs();
+    InstancedBarbs(const InstancedBarbs &) = delete;
+    InstancedBarbs &operator=(const InstancedBarbs &) = delete;
+
+    /// @brief compile the shader and create the buffers
+    /// @return false if the shader failed to build, the log is printed to std::cerr
+    bool init();
+    /// @brief whether init succeeded
+    bool isInitialised() const noexcept { return m_program != 0; }
+
+    /// @brief upload the per barb endpoints, the buffer only grows
+    /// @param[in] _roots the barb roots on the rachis, shared by both sides
+    /// @param[in] _leftTips the left barb tips, same size as _roots
+    /// @param[in] _rightTips the right barb tips, same size as _roots
+    void setInstances(std::span<const ngl::Vec3> _roots, std::span<const ngl::Vec3> _leftTips,
+                      std::span<const ngl::Vec3> _rightTips);
+    /// @brief set the factors shared by every barb
+    void setShape(const BarbShape &_shape) noexcept;
+    /// @brief number of barbs on each side
+    std::size_t numBarbs() const noexcept { return m_numBarbs; }
+
+    /// @brief draw every barb as a line strip with one instanced call
+    /// @param[in] _mvp the model view projection matrix
+    void draw(const ngl::Mat4 &_mvp) const noexcept;
+    /// @brief run the shader with transform feedback and read back the evaluated points,
+    /// used to check the shader against the CPU tessellation
+    /// @param[out] o_points 2 * numBarbs() * lod points in the BarbBuffer sample order
+    void capture(std::vector<ngl::Vec3> &o_points) const;
+
+private:
+    /// @brief set the shape and instance count uniforms on the program
+    void loadUniforms() const noexcept;
+
+    GLuint m_program = 0;
+    GLuint m_vao = 0;
+    GLuint m_instanceBuffer = 0;
+    /// @brief bytes allocated for m_instanceBuffer
+    std::size_t m_instanceCapacity = 0;
+    /// @brief interleaved p0, p3 per barb waiting for upload
+    std::vector<ngl::Vec3> m_staging;
+    std::size_t m_numBarbs = 0;
+    BarbShape m_shape;
+};
+
+#endif
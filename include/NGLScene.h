@@ -10,6 +10,10 @@ File description is kept same as of initial file.
 #include "WindowParams.h"
 #include <memory>
 #include "Feather.h"
+#include "FeatherGenerator.h"
+#include "FeatherRenderer.h"
+#include "FrameStats.h"
+#include "GpuTimer.h"
 #include <QOpenGLWidget>
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -63,14 +67,35 @@ class NGLScene : public QOpenGLWidget
     void resizeGL(int _w, int _h) override;
     
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief Get the Feather object for UI control
+    /// @brief Queue a parameter snapshot for the generation thread, the new geometry is
+    /// swapped in by the first paint after it is ready
     //----------------------------------------------------------------------------------------------------------------------
-    Feather* getFeather() { return m_feather.get(); }
+    void requestFeather(const FeatherParams &_params) { m_generator.post(_params); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Set the preview budget and refinement schedule used while parameters are edited
+    //----------------------------------------------------------------------------------------------------------------------
+    void setProgressive(const ProgressiveSettings &_settings) { m_generator.setProgressive(_settings); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Get the time each generation stage took for the feather on screen
+    //----------------------------------------------------------------------------------------------------------------------
+    FeatherStageTimes getStageTimes() const { return m_feather ? m_feather->getStageTimes() : FeatherStageTimes(); }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Set how the barbs of the full feather are drawn
+    //----------------------------------------------------------------------------------------------------------------------
+    void setBarbRenderMode(BarbRenderMode _mode) { m_renderer.setBarbRenderMode(_mode); }
     
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief Set the current draw mode
     //----------------------------------------------------------------------------------------------------------------------
     void setDrawMode(DrawMode mode) { m_drawMode = mode; }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief Get the number of bytes uploaded to GL buffers by the last frame
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t getFrameUploadBytes() const { return m_frameUploadBytes; }
     
 
 private:
@@ -95,12 +120,50 @@ private:
     /// @brief the curve to use
     //----------------------------------------------------------------------------------------------------------------------
     std::unique_ptr<BezierCurve> m_curve;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief builds feathers off the GL thread, m_feather is the last one taken from it
+    //----------------------------------------------------------------------------------------------------------------------
+    FeatherGenerator m_generator;
     std::unique_ptr<Feather> m_feather;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief GL copy of m_feather and the parameters it was uploaded from
+    //----------------------------------------------------------------------------------------------------------------------
+    FeatherRenderer m_renderer;
+    FeatherParams m_uploadedParams;
+    bool m_hasUpload = false;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief current draw mode
     //----------------------------------------------------------------------------------------------------------------------
     DrawMode m_drawMode = DrawMode::RACHIS;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bytes uploaded to GL buffers by the last frame
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_frameUploadBytes = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief timing overlay toggled with the T key
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_showStats = false;
+    FrameStats m_frameStats;
+    GpuTimer m_gpuTimer;
+    std::unique_ptr<ngl::Text> m_statsText;
+    /// @brief set once loading the overlay font failed, T then does nothing
+    bool m_statsUnavailable = false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief overlay text, rebuilt every s_statsRefreshFrames frames so drawing it stays cheap
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<std::string> m_statsLines;
+    unsigned int m_statsFrame = 0;
+    static constexpr unsigned int s_statsRefreshFrames = 15;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the timing overlay over the scene
+    //----------------------------------------------------------------------------------------------------------------------
+    void drawStats();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief load the overlay font once, warns and disables the overlay when it is missing
+    /// @return true when m_statsText can be drawn
+    //----------------------------------------------------------------------------------------------------------------------
+    bool loadStatsFont();
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief method to load transform matrices to the shader
     //----------------------------------------------------------------------------------------------------------------------
     void loadMatricesToShader();
@@ -127,6 +190,11 @@ private:
     /// @param _event the Qt Event structure
     //----------------------------------------------------------------------------------------------------------------------
     void wheelEvent( QWheelEvent *_event);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief this method is called every time a key is pressed, T toggles the timing overlay
+    /// @param _event the Qt Event structure
+    //----------------------------------------------------------------------------------------------------------------------
+    void keyPressEvent(QKeyEvent *_event) override;
 
 
 
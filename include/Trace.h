@@ -0,0 +1,63 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+/// @file Trace.h
+/// @brief scoped timers recorded into per thread ring buffers and written as Chrome trace event JSON
+///
+/// Wrap a block in FEATHER_TRACE_SCOPE("name") to time it. Recording is off until
+/// setTracingEnabled(true), a disabled scope costs one relaxed atomic load.
+/// Defining FEATHER_DISABLE_TRACING removes every scope at compile time.
+/// The output loads in chrome://tracing and ui.perfetto.dev.
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/// @brief start or stop recording scopes on every thread
+void setTracingEnabled(bool _enabled) noexcept;
+
+/// @brief whether scopes are being recorded
+bool isTracingEnabled() noexcept;
+
+/// @brief set how many events each thread keeps, older events are overwritten,
+/// applies to buffers created after the call
+void setTraceCapacity(std::size_t _eventsPerThread) noexcept;
+
+/// @brief drop every recorded event
+void clearTrace();
+
+/// @brief write every recorded event as trace event JSON, oldest first on each thread
+/// @return the number of events written
+std::size_t writeTrace(std::ostream &_out);
+
+/// @brief write the trace to a file
+/// @return false if the file could not be opened
+bool writeTraceFile(const std::string &_path);
+
+/// @brief enable tracing and write the trace to _path when the program exits
+void dumpTraceAtExit(const std::string &_path);
+
+/// @brief times its own lifetime and records it as a complete event
+class TraceScope
+{
+public:
+    /// @param[in] _name must outlive the trace, a string literal
+    explicit TraceScope(const char *_name) noexcept;
+    ~TraceScope() noexcept;
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    /// @brief null when tracing was off as the scope opened
+    const char *m_name;
+    std::uint64_t m_start = 0;
+};
+
+#define FEATHER_TRACE_CONCAT_(_a, _b) _a##_b
+#define FEATHER_TRACE_CONCAT(_a, _b) FEATHER_TRACE_CONCAT_(_a, _b)
+#ifdef FEATHER_DISABLE_TRACING
+#define FEATHER_TRACE_SCOPE(_name) static_cast<void>(0)
+#else
+#define FEATHER_TRACE_SCOPE(_name) TraceScope FEATHER_TRACE_CONCAT(traceScope_, __LINE__)(_name)
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef VERTEXUPLOAD_H_
+#define VERTEXUPLOAD_H_
+/// @file VertexUpload.h
+/// @brief streaming of vertex data into persistent GL buffers, counting of the bytes uploaded and of the draws issued
+#include "ngl/Types.h"
+#include "ngl/Vec3.h"
+#include "ngl/AbstractVAO.h"
+#include <cstddef>
+
+/// @brief add _bytes to the count of bytes sent to GL buffers
+void recordUpload(std::size_t _bytes) noexcept;
+
+/// @brief get the bytes sent to GL buffers since the last call and restart the count,
+/// called once per frame this is the upload cost of the frame
+std::size_t takeUploadedBytes() noexcept;
+
+/// @brief draw calls and vertices issued since the last takeDrawCounts
+struct DrawCounts
+{
+    std::size_t calls = 0;
+    std::size_t vertices = 0;
+};
+
+/// @brief count one draw call of _vertices vertices
+void recordDraw(std::size_t _vertices) noexcept;
+
+/// @brief get the draws issued since the last call and restart the count
+DrawCounts takeDrawCounts() noexcept;
+
+/// @brief write points into the buffer of a VAO that stays alive between updates,
+/// the buffer is only reallocated when it has to grow, otherwise it is overwritten
+/// in place with glBufferSubData
+/// @param[in] _vao the VAO to update, must be bound
+/// @param[in,out] io_capacity the number of points the VAO's buffer holds, 0 for a new VAO
+/// @param[in] _points the points to upload
+/// @param[in] _count the number of points
+void streamPoints(ngl::AbstractVAO &_vao, std::size_t &io_capacity, const ngl::Vec3 *_points, std::size_t _count);
+
+#endif
@@ -30,10 +30,12 @@ private slots:
     void onSymmetricalChanged(bool checked);
 
 private:
-    void updateRachis();
-    void updateOutlines();
-    void updateBarbs();
-    void updateAllFeather();
+    void updateRachis(FeatherParams &o_params) const;
+    void updateOutlines(FeatherParams &o_params) const;
+    void updateBarbs(FeatherParams &o_params) const;
+    void updateAllFeather(FeatherParams &o_params) const;
+    /// @brief read every control into a snapshot and queue it for generation
+    void postParams();
     void setupConnections();
     
     Ui::MainWindow *ui;
@@ -0,0 +1,49 @@
+/// @file Arena.cpp
+/// @brief bump allocator for the plain arrays of generated geometry
+
+#include "Arena.h"
+#include <algorithm>
+
+Arena::Arena(std::size_t _blockBytes) : m_blockBytes(std::max<std::size_t>(_blockBytes, 64))
+{
+}
+
+void Arena::reset() noexcept
+{
+    m_block = 0;
+    m_offset = 0;
+    m_bytesUsed = 0;
+}
+
+std::size_t Arena::capacity() const noexcept
+{
+    std::size_t bytes = 0;
+    for (const Block &block : m_blocks)
+        bytes += block.size;
+    return bytes;
+}
+
+void *Arena::allocateBytes(std::size_t _bytes, std::size_t _alignment)
+{
+    // operator new[] aligns blocks for every fundamental type, so aligning offsets is enough
+    for (; m_block < m_blocks.size(); ++m_block, m_offset = 0)
+    {
+        Block &block = m_blocks[m_block];
+        const std::size_t offset = (m_offset + _alignment - 1) / _alignment * _alignment;
+        if (offset + _bytes <= block.size)
+        {
+            m_offset = offset + _bytes;
+            m_bytesUsed += _bytes;
+            return block.data.get() + offset;
+        }
+    }
+
+    Block block;
+    block.size = std::max(m_blockBytes, _bytes);
+    block.data = std::make_unique<std::byte[]>(block.size);
+    m_blocks.push_back(std::move(block));
+    m_block = m_blocks.size() - 1;
+    m_offset = _bytes;
+    m_bytesUsed += _bytes;
+    return m_blocks.back().data.get();
+}
@@ -0,0 +1,190 @@
+/// @file BarbBatch.cpp
+/// @brief batched tessellation of many cubic curves stored in structure of arrays layout
+
+#include "BarbBatch.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FEATHER_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define FEATHER_X86_SIMD 0
+#endif
+
+namespace
+{
+// Each kernel walks the rows of the basis table (one per sample) and multiplies
+// them with the 4 x 3N control point matrix of the batch, 4 or 8 curves at a time.
+
+/// @brief plain C++ version used for the tail of the batch and on non x86 cpus
+void evaluateScalar(const CubicBatch &_batch, const BernsteinBasis &_basis, std::size_t _begin, std::size_t _end,
+                    ngl::Vec3 *o_samples) noexcept
+{
+    const unsigned int lod = _basis.lod();
+    for (unsigned int s = 0; s < lod; ++s)
+    {
+        const ngl::Real *w = _basis.row(s);
+        for (std::size_t i = _begin; i < _end; ++i)
+        {
+            ngl::Vec3 &p = o_samples[i * lod + s];
+            p.m_x = w[0] * _batch.x[0][i] + w[1] * _batch.x[1][i] + w[2] * _batch.x[2][i] + w[3] * _batch.x[3][i];
+            p.m_y = w[0] * _batch.y[0][i] + w[1] * _batch.y[1][i] + w[2] * _batch.y[2][i] + w[3] * _batch.y[3][i];
+            p.m_z = w[0] * _batch.z[0][i] + w[1] * _batch.z[1][i] + w[2] * _batch.z[2][i] + w[3] * _batch.z[3][i];
+        }
+    }
+}
+
+#if FEATHER_X86_SIMD
+/// @brief 4 curves per iteration, returns the index of the first curve not processed
+__attribute__((target("sse2")))
+std::size_t evaluateSSE(const CubicBatch &_batch, const BernsteinBasis &_basis, std::size_t _begin, std::size_t _end,
+                       ngl::Vec3 *o_samples) noexcept
+{
+    const unsigned int lod = _basis.lod();
+    alignas(16) float bx[4], by[4], bz[4];
+    std::size_t i = _begin;
+    for (; i + 4 <= _end; i += 4)
+    {
+        const __m128 x0 = _mm_loadu_ps(&_batch.x[0][i]), x1 = _mm_loadu_ps(&_batch.x[1][i]);
+        const __m128 x2 = _mm_loadu_ps(&_batch.x[2][i]), x3 = _mm_loadu_ps(&_batch.x[3][i]);
+        const __m128 y0 = _mm_loadu_ps(&_batch.y[0][i]), y1 = _mm_loadu_ps(&_batch.y[1][i]);
+        const __m128 y2 = _mm_loadu_ps(&_batch.y[2][i]), y3 = _mm_loadu_ps(&_batch.y[3][i]);
+        const __m128 z0 = _mm_loadu_ps(&_batch.z[0][i]), z1 = _mm_loadu_ps(&_batch.z[1][i]);
+        const __m128 z2 = _mm_loadu_ps(&_batch.z[2][i]), z3 = _mm_loadu_ps(&_batch.z[3][i]);
+        for (unsigned int s = 0; s < lod; ++s)
+        {
+            const ngl::Real *w = _basis.row(s);
+            const __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]);
+            const __m128 w2 = _mm_set1_ps(w[2]), w3 = _mm_set1_ps(w[3]);
+            _mm_store_ps(bx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, x0), _mm_mul_ps(w1, x1)),
+                                        _mm_add_ps(_mm_mul_ps(w2, x2), _mm_mul_ps(w3, x3))));
+            _mm_store_ps(by, _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, y0), _mm_mul_ps(w1, y1)),
+                                        _mm_add_ps(_mm_mul_ps(w2, y2), _mm_mul_ps(w3, y3))));
+            _mm_store_ps(bz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, z0), _mm_mul_ps(w1, z1)),
+                                        _mm_add_ps(_mm_mul_ps(w2, z2), _mm_mul_ps(w3, z3))));
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                o_samples[(i + k) * lod + s] = ngl::Vec3(bx[k], by[k], bz[k]);
+            }
+        }
+    }
+    return i;
+}
+
+/// @brief 8 curves per iteration, returns the index of the first curve not processed
+__attribute__((target("avx2,fma")))
+std::size_t evaluateAVX2(const CubicBatch &_batch, const BernsteinBasis &_basis, std::size_t _begin, std::size_t _end,
+                       ngl::Vec3 *o_samples) noexcept
+{
+    const unsigned int lod = _basis.lod();
+    alignas(32) float bx[8], by[8], bz[8];
+    std::size_t i = _begin;
+    for (; i + 8 <= _end; i += 8)
+    {
+        const __m256 x0 = _mm256_loadu_ps(&_batch.x[0][i]), x1 = _mm256_loadu_ps(&_batch.x[1][i]);
+        const __m256 x2 = _mm256_loadu_ps(&_batch.x[2][i]), x3 = _mm256_loadu_ps(&_batch.x[3][i]);
+        const __m256 y0 = _mm256_loadu_ps(&_batch.y[0][i]), y1 = _mm256_loadu_ps(&_batch.y[1][i]);
+        const __m256 y2 = _mm256_loadu_ps(&_batch.y[2][i]), y3 = _mm256_loadu_ps(&_batch.y[3][i]);
+        const __m256 z0 = _mm256_loadu_ps(&_batch.z[0][i]), z1 = _mm256_loadu_ps(&_batch.z[1][i]);
+        const __m256 z2 = _mm256_loadu_ps(&_batch.z[2][i]), z3 = _mm256_loadu_ps(&_batch.z[3][i]);
+        for (unsigned int s = 0; s < lod; ++s)
+        {
+            const ngl::Real *w = _basis.row(s);
+            const __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]);
+            const __m256 w2 = _mm256_set1_ps(w[2]), w3 = _mm256_set1_ps(w[3]);
+            _mm256_store_ps(bx, _mm256_fmadd_ps(w3, x3, _mm256_fmadd_ps(w2, x2, _mm256_fmadd_ps(w1, x1, _mm256_mul_ps(w0, x0)))));
+            _mm256_store_ps(by, _mm256_fmadd_ps(w3, y3, _mm256_fmadd_ps(w2, y2, _mm256_fmadd_ps(w1, y1, _mm256_mul_ps(w0, y0)))));
+            _mm256_store_ps(bz, _mm256_fmadd_ps(w3, z3, _mm256_fmadd_ps(w2, z2, _mm256_fmadd_ps(w1, z1, _mm256_mul_ps(w0, z0)))));
+            for (std::size_t k = 0; k < 8; ++k)
+            {
+                o_samples[(i + k) * lod + s] = ngl::Vec3(bx[k], by[k], bz[k]);
+            }
+        }
+    }
+    return i;
+}
+#endif
+} // end anonymous namespace
+
+SimdLevel detectSimdLevel() noexcept
+{
+#if FEATHER_X86_SIMD
+    static const SimdLevel level = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return SimdLevel::SSE;
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+const char *simdLevelName(SimdLevel _level) noexcept
+{
+    switch (_level)
+    {
+        case SimdLevel::AVX2 : return "AVX2";
+        case SimdLevel::SSE : return "SSE";
+        default : return "scalar";
+    }
+}
+
+void CubicBatch::resize(std::size_t _numCurves)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        x[k].resize(_numCurves);
+        y[k].resize(_numCurves);
+        z[k].resize(_numCurves);
+    }
+}
+
+void CubicBatch::set(std::size_t _index, const ngl::Vec3 *_cp) noexcept
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        x[k][_index] = _cp[k].m_x;
+        y[k][_index] = _cp[k].m_y;
+        z[k][_index] = _cp[k].m_z;
+    }
+}
+
+void CubicBatch::get(std::size_t _index, ngl::Vec3 *o_cp) const noexcept
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        o_cp[k] = ngl::Vec3(x[k][_index], y[k][_index], z[k][_index]);
+    }
+}
+
+void evaluateCubicBatch(const CubicBatch &_batch, const BernsteinBasis &_basis, ngl::Vec3 *o_samples, SimdLevel _level) noexcept
+{
+    evaluateCubicBatch(_batch, _basis, 0, _batch.size(), o_samples, _level);
+}
+
+void evaluateCubicBatch(const CubicBatch &_batch, const BernsteinBasis &_basis, std::size_t _begin, std::size_t _end,
+                        ngl::Vec3 *o_samples, SimdLevel _level) noexcept
+{
+    _end = std::min(_end, _batch.size());
+    if (_basis.lod() == 0 || _basis.degree() != 3 || _begin >= _end)
+        return;
+    // never run an instruction set the cpu does not have
+    if (static_cast<int>(_level) > static_cast<int>(detectSimdLevel()))
+        _level = detectSimdLevel();
+
+    std::size_t done = _begin;
+#if FEATHER_X86_SIMD
+    switch (_level)
+    {
+        case SimdLevel::AVX2 : done = evaluateAVX2(_batch, _basis, _begin, _end, o_samples); break;
+        case SimdLevel::SSE : done = evaluateSSE(_batch, _basis, _begin, _end, o_samples); break;
+        default : break;
+    }
+#endif
+    evaluateScalar(_batch, _basis, done, _end, o_samples);
+}
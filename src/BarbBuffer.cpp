@@ -0,0 +1,38 @@
+/// @file BarbBuffer.cpp
+/// @brief every barb of a feather stored in contiguous arrays with lightweight index views
+
+#include "BarbBuffer.h"
+
+void BarbBuffer::resize(std::size_t _numBarbs, unsigned int _lod)
+{
+    m_numBarbs = _numBarbs;
+    m_lod = _lod;
+    m_controlPoints.resize(size());
+    m_samples.resize(size() * m_lod);
+
+    // the draw ranges only depend on the barb count and LOD
+    const bool layoutChanged = m_drawFirsts.size() != size() ||
+                               (!m_drawCounts.empty() && m_drawCounts[0] != static_cast<std::int32_t>(m_lod));
+    if (layoutChanged)
+    {
+        m_drawFirsts.resize(size());
+        m_drawCounts.assign(size(), static_cast<std::int32_t>(m_lod));
+        for (std::size_t b = 0; b < size(); ++b)
+        {
+            m_drawFirsts[b] = static_cast<std::int32_t>(b * m_lod);
+        }
+    }
+}
+
+void BarbBuffer::clear() noexcept
+{
+    m_numBarbs = 0;
+    m_controlPoints.resize(0);
+    m_samples.clear();
+}
+
+std::span<const ngl::Vec3> BarbBuffer::sideSamples(BarbSide _side) const noexcept
+{
+    const std::size_t count = m_numBarbs * m_lod;
+    return samples().subspan(_side == BarbSide::LEFT ? 0 : count, count);
+}
@@ -0,0 +1,332 @@
+/// @file BatchPipeline.cpp
+/// @brief read -> generate -> write pipeline for batches of parameter files
+
+#include "BatchPipeline.h"
+#include "Feather.h"
+#include "FeatherIO.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point _start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - _start).count();
+    }
+
+    /// @brief a parsed parameter file on its way to a worker
+    struct BatchJob
+    {
+        std::size_t index = 0;
+        std::string name;
+        FeatherParams params;
+        std::string error;
+    };
+
+    /// @brief counts the feathers between reading and writing, the reader waits at the limit
+    class InFlightLimit
+    {
+    public:
+        explicit InFlightLimit(std::size_t _limit) : m_limit(_limit) {}
+
+        /// @return false once close was called, the feather must not be started
+        bool acquire()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this]() { return m_count < m_limit || m_closed; });
+            if (m_closed)
+            {
+                return false;
+            }
+            m_max = std::max(m_max, ++m_count);
+            return true;
+        }
+
+        void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_count;
+            }
+            m_changed.notify_one();
+        }
+
+        /// @brief release a waiting acquire for good, used when the run is abandoned
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_changed.notify_all();
+        }
+
+        std::size_t max() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_max;
+        }
+
+    private:
+        const std::size_t m_limit;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::size_t m_count = 0;
+        std::size_t m_max = 0;
+        bool m_closed = false;
+    };
+
+    /// @brief read a whole file, the parse happens after the I/O
+    bool readFile(const std::filesystem::path &_path, std::string &o_text)
+    {
+        std::ifstream file(_path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        o_text = std::move(text).str();
+        return true;
+    }
+
+    StageStats stageStats(unsigned int _threads, std::size_t _items, double _busyMs, double _wallMs)
+    {
+        StageStats stats;
+        stats.threads = _threads;
+        stats.items = _items;
+        stats.busyMs = _busyMs;
+        stats.occupancy = _wallMs > 0.0 ? _busyMs / (_wallMs * _threads) : 0.0;
+        return stats;
+    }
+} // end anonymous namespace
+
+BatchStats runBatchPipeline(const std::vector<std::filesystem::path> &_files, const BatchSettings &_settings,
+                            const BatchSink &_sink)
+{
+    FEATHER_TRACE_SCOPE("runBatchPipeline");
+    const unsigned int numWorkers = _settings.workers != 0 ? _settings.workers
+                                                           : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t capacity = _settings.queueCapacity != 0 ? _settings.queueCapacity : 2 * numWorkers;
+    const unsigned int variants = std::max(1u, _settings.variants);
+    BoundedQueue<BatchJob> parsed(capacity);
+    BoundedQueue<BatchResult> generated(capacity);
+    // both queues full plus one feather per worker, anything more would only wait in the reorder buffer
+    InFlightLimit inFlight(2 * capacity + numWorkers);
+    const auto start = Clock::now();
+
+    double readBusyMs = 0.0;
+    std::size_t readItems = 0;
+    std::thread reader([&]()
+    {
+        std::string text;
+        std::size_t index = 0;
+        // the sink writes name.obj, a name taken twice would overwrite the earlier feather
+        std::map<std::string, std::filesystem::path> names;
+        for (const std::filesystem::path &file : _files)
+        {
+            const auto busy = Clock::now();
+            BatchJob job;
+            try
+            {
+                if (!readFile(file, text))
+                {
+                    job.error = "cannot open " + file.string();
+                }
+                else
+                {
+                    FEATHER_TRACE_SCOPE("batch parse");
+                    std::istringstream in(text);
+                    if (!readFeatherParams(in, job.params, job.error))
+                    {
+                        job.error = file.string() + ": " + job.error;
+                    }
+                }
+            }
+            catch (const std::exception &_e)
+            {
+                job.error = file.string() + ": " + _e.what();
+            }
+            const std::string stem = file.stem().string();
+            readBusyMs += millisecondsSince(busy);
+            ++readItems;
+            for (unsigned int variant = 0; variant < variants; ++variant)
+            {
+                BatchJob variantJob = job;
+                variantJob.index = index++;
+                variantJob.name = variants > 1 ? stem + "_" + std::to_string(variant) : stem;
+                variantJob.params.seed += variant;
+                const auto [named, added] = names.emplace(variantJob.name, file);
+                if (!added && variantJob.error.empty())
+                {
+                    variantJob.error = file.string() + ": output name " + variantJob.name + " is already used by " +
+                                       named->second.string();
+                }
+                // both fail only once the writer has given up on the run
+                if (!inFlight.acquire() || !parsed.push(std::move(variantJob)))
+                {
+                    parsed.close();
+                    return;
+                }
+            }
+        }
+        parsed.close();
+    });
+
+    std::atomic<unsigned int> activeWorkers{numWorkers};
+    std::vector<double> generateBusyMs(numWorkers, 0.0);
+    std::vector<std::thread> workers;
+    for (unsigned int w = 0; w < numWorkers; ++w)
+    {
+        workers.emplace_back([&, w]()
+        {
+            // one Feather per worker, so a job only rebuilds the stages that differ from the
+            // worker's previous job, such as just the barbs for another variant of the same file
+            auto feather = std::make_unique<Feather>();
+            feather->setNumThreads(1);
+            std::ostringstream obj;
+            BatchJob job;
+            while (parsed.pop(job))
+            {
+                const auto busy = Clock::now();
+                BatchResult result;
+                result.index = job.index;
+                result.name = std::move(job.name);
+                result.error = std::move(job.error);
+                if (result.error.empty())
+                {
+                    FEATHER_TRACE_SCOPE("batch generate");
+                    try
+                    {
+                        feather->setParams(job.params);
+                        feather->generate();
+                        if (_settings.serialise)
+                        {
+                            obj.str(std::string());
+                            writeFeatherObj(obj, feather->getGeometry(), _settings.outlines);
+                            result.obj = std::move(obj).str();
+                        }
+                    }
+                    catch (const std::exception &_e)
+                    {
+                        // typically bad_alloc for a huge feather, the next job starts from scratch
+                        result.obj.clear();
+                        result.error = result.name + ": " + _e.what();
+                        feather = std::make_unique<Feather>();
+                        feather->setNumThreads(1);
+                    }
+                }
+                generateBusyMs[w] += millisecondsSince(busy);
+                generated.push(std::move(result));
+            }
+            if (--activeWorkers == 0)
+            {
+                generated.close();
+            }
+        });
+    }
+
+    auto joinStages = [&]()
+    {
+        reader.join();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    };
+
+    // The writer runs here, results arrive in any order and leave in batch order
+    BatchStats stats;
+    double writeBusyMs = 0.0;
+    std::map<std::size_t, BatchResult> reorder;
+    std::size_t next = 0;
+    try
+    {
+        BatchResult result;
+        while (generated.pop(result))
+        {
+            reorder.emplace(result.index, std::move(result));
+            for (auto it = reorder.begin(); it != reorder.end() && it->first == next;
+                 it = reorder.erase(it), ++next)
+            {
+                const auto busy = Clock::now();
+                FEATHER_TRACE_SCOPE("batch write");
+                const BatchResult &ready = it->second;
+                const bool written = _sink(ready);
+                if (!ready.error.empty() || !written)
+                {
+                    ++stats.failed;
+                }
+                else
+                {
+                    ++stats.feathers;
+                }
+                stats.objBytes += ready.obj.size();
+                writeBusyMs += millisecondsSince(busy);
+                inFlight.release();
+            }
+        }
+    }
+    catch (...)
+    {
+        // a throwing sink ends the run, the other stages stop at their next queue operation
+        inFlight.close();
+        parsed.close();
+        generated.close();
+        joinStages();
+        throw;
+    }
+    joinStages();
+
+    stats.wallMs = millisecondsSince(start);
+    double totalGenerateMs = 0.0;
+    for (double ms : generateBusyMs)
+    {
+        totalGenerateMs += ms;
+    }
+    stats.read = stageStats(1, readItems, readBusyMs, stats.wallMs);
+    stats.generate = stageStats(numWorkers, next, totalGenerateMs, stats.wallMs);
+    stats.write = stageStats(1, next, writeBusyMs, stats.wallMs);
+    stats.parsedQueue = parsed.stats();
+    stats.generatedQueue = generated.stats();
+    stats.maxInFlight = inFlight.max();
+    return stats;
+}
+
+std::vector<std::string> BatchStats::lines() const
+{
+    std::vector<std::string> lines;
+    char line[128];
+    auto add = [&lines, &line](int _length) {
+        if (_length > 0)
+            lines.emplace_back(line, std::min<std::size_t>(static_cast<std::size_t>(_length), sizeof(line) - 1));
+    };
+    auto stage = [&](const char *_name, const StageStats &_stage) {
+        add(std::snprintf(line, sizeof(line), "%-9s %3u threads %7zu items %10.1f ms busy %5.1f%% occupied",
+                          _name, _stage.threads, _stage.items, _stage.busyMs, 100.0 * _stage.occupancy));
+    };
+    auto queue = [&](const char *_name, const QueueStats &_queue) {
+        add(std::snprintf(line, sizeof(line),
+                          "  %-9s queue %4.1f / %zu mean, %zu max, %8.1f ms full, %8.1f ms empty",
+                          _name, _queue.meanSize, _queue.capacity, _queue.maxSize, _queue.pushWaitMs,
+                          _queue.popWaitMs));
+    };
+    stage("read", read);
+    queue("parsed", parsedQueue);
+    stage("generate", generate);
+    queue("generated", generatedQueue);
+    stage("write", write);
+    add(std::snprintf(line, sizeof(line), "%zu feathers, %zu failed, %.1f feathers/sec, %zu in flight at most",
+                      feathers, failed, feathersPerSecond(), maxInFlight));
+    return lines;
+}
@@ -0,0 +1,38 @@
+/// @file BernsteinBasis.cpp
+/// @brief table of Bernstein weights for uniform tessellation at a fixed degree and LOD
+
+#include "BernsteinBasis.h"
+#include "BezierN.h"
+#include <cmath>
+
+BernsteinBasis::BernsteinBasis(unsigned int _degree, unsigned int _lod)
+{
+    rebuild(_degree, _lod);
+}
+
+void BernsteinBasis::rebuild(unsigned int _degree, unsigned int _lod)
+{
+    m_degree = _degree;
+    m_lod = _lod;
+    const unsigned int numCPs = _degree + 1;
+    m_weights.resize(static_cast<size_t>(_lod) * numCPs);
+
+    for (unsigned int s = 0; s < _lod; ++s)
+    {
+        const ngl::Real t = static_cast<ngl::Real>(s) / _lod;
+        ngl::Real *w = &m_weights[s * numCPs];
+        if (_degree == 3)
+        {
+            // match the cubic kernel exactly
+            BezierN<3>::weights(t, w);
+            continue;
+        }
+        ngl::Real binomial = 1.0f;
+        for (unsigned int k = 0; k <= _degree; ++k)
+        {
+            w[k] = binomial * std::pow(t, static_cast<ngl::Real>(k)) *
+                   std::pow(1.0f - t, static_cast<ngl::Real>(_degree - k));
+            binomial = binomial * static_cast<ngl::Real>(_degree - k) / static_cast<ngl::Real>(k + 1);
+        }
+    }
+}
@@ -8,7 +8,11 @@
 /// @brief basic BezierCurve using deCasteljau algorithm
 
 #include "Curve.h"
+#include "BezierN.h"
+#include "Trace.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 
 BezierCurve::BezierCurve( const std::vector<ngl::Vec3> &_p) noexcept : m_cp{_p}
@@ -20,36 +24,45 @@ BezierCurve::BezierCurve( const std::vector<ngl::Vec3> &_p) noexcept : m_cp{_p}
 BezierCurve::~BezierCurve() noexcept
 {
 	m_cp.clear();
-	if(m_vaoCurve!=nullptr && m_vaoPoints!=nullptr)
-	{
-		m_vaoCurve->unbind();
-		m_vaoCurve->removeVAO();
-		m_vaoPoints->unbind();
-		m_vaoPoints->removeVAO();
-	}
 }
 
-ngl::Vec3 BezierCurve::lerp(ngl::Real _t, ngl::Vec3& p0, ngl::Vec3& p1) noexcept
+ngl::Vec3 BezierCurve::lerp(ngl::Real _t, const ngl::Vec3& p0, const ngl::Vec3& p1) noexcept
 {
 	ngl::Vec3 p;
 	p.m_x=(1-_t)*p0.m_x +_t*p1.m_x;
 	p.m_y=(1-_t)*p0.m_y +_t*p1.m_y;
 	p.m_z=(1-_t)*p0.m_z +_t*p1.m_z;
-	// std::cout << p.m_x << ' ' << p.m_y << ' ' << p.m_z <<'\n';
 	return p;
 }
 
-	ngl::Vec3 BezierCurve::deCasteljau(ngl::Real _t, std::vector<ngl::Vec3>& p_list) noexcept
+ngl::Vec3 BezierCurve::deCasteljau(ngl::Real _t, std::vector<ngl::Vec3>& p_list) noexcept
 {
-	size_t n = p_list.size() - 1;
-	if (n == 0)
-		return p_list[0];
+	return deCasteljau(_t, p_list.data(), p_list.size());
+}
 
-	std::vector<ngl::Vec3> new_points(n);
-	for (size_t i = 0; i < n; ++i) {
-		new_points[i] = lerp(_t, p_list[i], p_list[i + 1]);
+ngl::Vec3 BezierCurve::deCasteljau(ngl::Real _t, const ngl::Vec3 *_cp, size_t _numCP) noexcept
+{
+	if (_numCP == 0)
+		return ngl::Vec3();
+
+	// each level overwrites the working points in place with the same lerps the
+	// recursive version produced, so the result is bit identical
+	ngl::Vec3 stackPts[s_maxStackCPs];
+	ngl::Vec3 *pts = stackPts;
+	if (_numCP > s_maxStackCPs) {
+		static thread_local std::vector<ngl::Vec3> scratch;
+		if (scratch.size() < _numCP)
+			scratch.resize(_numCP);
+		pts = scratch.data();
+	}
+	std::copy(_cp, _cp + _numCP, pts);
+
+	for (size_t n = _numCP - 1; n > 0; --n) {
+		for (size_t i = 0; i < n; ++i) {
+			pts[i] = lerp(_t, pts[i], pts[i + 1]);
+		}
 	}
-	return deCasteljau(_t, new_points);
+	return pts[0];
 }
 
 void BezierCurve::addPoint( const ngl::Vec3 &_p ) noexcept
@@ -58,6 +71,7 @@ void BezierCurve::addPoint( const ngl::Vec3 &_p ) noexcept
 	++m_numCP;
 	++m_degree;
 	m_samplePtsDirty = true;
+	m_arcLengthsDirty = true;
 	#ifdef DEBUG
     std::cout <<"Added "<<m_numCP<<" m_degree "<<m_degree<<" m_numKnots"<<m_numKnots<<" m_order "<<m_order<<'\n';
 	#endif
@@ -70,103 +84,396 @@ void BezierCurve::addPoint( ngl::Real _x,  ngl::Real _y, ngl::Real _z) noexcept
 	++m_numCP;
 	++m_degree;
 	m_samplePtsDirty = true;
+	m_arcLengthsDirty = true;
 	#ifdef DEBUG
     std::cout <<"Added "<<m_numCP<<" m_degree "<<m_degree<<" m_numKnots"<<m_numKnots<<" m_order "<<m_order<<'\n';
 	#endif
 }
 
+void BezierCurve::setControlPoints(std::span<const ngl::Vec3> _cp) noexcept
+{
+	m_cp.assign(_cp.begin(), _cp.end());
+	m_numCP = static_cast<unsigned int>(m_cp.size());
+	m_degree = m_numCP;
+	m_samplePtsDirty = true;
+	m_arcLengthsDirty = true;
+}
+
 ngl::Vec3 BezierCurve::getPointOnCurve( const ngl::Real _value ) noexcept
 {
-	ngl::Vec3 p;
-	p = deCasteljau(_value, m_cp);
-	return p;
+	// every curve of the feather is a cubic so route the common degrees to the
+	// compile time specialised kernels and keep deCasteljau for everything else
+	switch (m_cp.size())
+	{
+		case 4 : return BezierN<3>::evaluate(m_cp.data(), _value);
+		case 3 : return BezierN<2>::evaluate(m_cp.data(), _value);
+		default : return deCasteljau(_value, m_cp.data(), m_cp.size());
+	}
 }
 
-void BezierCurve::setLOD(unsigned int lod) noexcept
+void BezierCurve::evaluate(std::span<const ngl::Real> _ts, std::span<ngl::Vec3> o_points) const noexcept
 {
-	if(m_lod != lod){
-		m_lod = lod;
-		m_samplePtsDirty = true;
+	const size_t count = std::min(_ts.size(), o_points.size());
+	const ngl::Vec3 *cp = m_cp.data();
+	// one independent blend per parameter with no branches inside the loop so the
+	// compiler can keep the control points in registers and vectorise the weights
+	switch (m_cp.size())
+	{
+		case 4 :
+			for (size_t i = 0; i < count; ++i)
+				o_points[i] = BezierN<3>::evaluate(cp, _ts[i]);
+			break;
+		case 3 :
+			for (size_t i = 0; i < count; ++i)
+				o_points[i] = BezierN<2>::evaluate(cp, _ts[i]);
+			break;
+		default :
+			for (size_t i = 0; i < count; ++i)
+				o_points[i] = deCasteljau(_ts[i], cp, m_cp.size());
+			break;
 	}
 }
 
-std::vector<ngl::Vec3> BezierCurve::getSamplePoints() noexcept
+void BezierCurve::evaluateWithDerivatives(std::span<const ngl::Real> _ts, std::span<CurveSample> o_samples) const noexcept
 {
-	if (m_samplePtsDirty) {
-		m_samplePts.resize(m_lod);
-		for(unsigned int i = 0; i < m_lod; ++i) {
-			ngl::Real t = static_cast<float>(i) / m_lod;
-			m_samplePts[i] = getPointOnCurve(t);
+	const size_t count = std::min(_ts.size(), o_samples.size());
+	const size_t n = m_cp.size();
+	if (n == 4) {
+		for (size_t i = 0; i < count; ++i)
+			BezierN<3>::evaluateWithDerivatives(m_cp.data(), _ts[i], o_samples[i].position, o_samples[i].d1, o_samples[i].d2);
+		return;
+	}
+
+	// generic degree, build the first and second hodographs once for every parameter
+	ngl::Vec3 stackPts[2 * s_maxStackCPs];
+	ngl::Vec3 *d1Pts = stackPts;
+	if (n > s_maxStackCPs) {
+		static thread_local std::vector<ngl::Vec3> scratch;
+		if (scratch.size() < 2 * n)
+			scratch.resize(2 * n);
+		d1Pts = scratch.data();
+	}
+	ngl::Vec3 *d2Pts = d1Pts + n;
+	const size_t n1 = n > 1 ? n - 1 : 0;
+	const size_t n2 = n > 2 ? n - 2 : 0;
+	for (size_t i = 0; i < n1; ++i)
+		d1Pts[i] = (m_cp[i + 1] - m_cp[i]) * static_cast<ngl::Real>(n1);
+	for (size_t i = 0; i < n2; ++i)
+		d2Pts[i] = (d1Pts[i + 1] - d1Pts[i]) * static_cast<ngl::Real>(n2);
+
+	for (size_t i = 0; i < count; ++i) {
+		o_samples[i].position = deCasteljau(_ts[i], m_cp.data(), n);
+		o_samples[i].d1 = deCasteljau(_ts[i], d1Pts, n1);
+		o_samples[i].d2 = deCasteljau(_ts[i], d2Pts, n2);
+	}
+}
+
+void BezierCurve::getSampleFrames(std::vector<CurveFrame> &o_frames) const noexcept
+{
+	o_frames.resize(m_lod);
+	if (m_lod == 0 || m_cp.size() < 2)
+		return;
+
+	auto sampleAt = [this](unsigned int _i)
+	{
+		const ngl::Real t = static_cast<ngl::Real>(_i) / m_lod;
+		CurveSample sample;
+		evaluateWithDerivatives(std::span<const ngl::Real>(&t, 1), std::span<CurveSample>(&sample, 1));
+		return sample;
+	};
+	auto unitTangent = [](const CurveSample &_s)
+	{
+		ngl::Vec3 t = _s.d1;
+		t.normalize();
+		return t;
+	};
+
+	// initial normal is the curvature direction, or any perpendicular on a straight start
+	CurveSample sample = sampleAt(0);
+	CurveFrame &first = o_frames[0];
+	first.position = sample.position;
+	first.tangent = unitTangent(sample);
+	ngl::Vec3 normal = sample.d2 - first.tangent * sample.d2.dot(first.tangent);
+	if (normal.lengthSquared() < 1e-12f) {
+		ngl::Vec3 axis = std::abs(first.tangent.m_x) < 0.9f ? ngl::Vec3(1.0f, 0.0f, 0.0f) : ngl::Vec3(0.0f, 1.0f, 0.0f);
+		normal = axis - first.tangent * axis.dot(first.tangent);
+	}
+	normal.normalize();
+	first.normal = normal;
+	first.binormal = first.tangent.cross(first.normal);
+
+	// double reflection (Wang et al. 2008), reflect the frame across the bisector plane
+	// of the sample step then across the plane correcting the tangent
+	for (unsigned int i = 1; i < m_lod; ++i) {
+		const CurveFrame &prev = o_frames[i - 1];
+		CurveFrame &frame = o_frames[i];
+		sample = sampleAt(i);
+		frame.position = sample.position;
+		frame.tangent = unitTangent(sample);
+
+		const ngl::Vec3 v1 = frame.position - prev.position;
+		const ngl::Real c1 = v1.dot(v1);
+		ngl::Vec3 rL = prev.normal;
+		ngl::Vec3 tL = prev.tangent;
+		if (c1 > 0.0f) {
+			rL = prev.normal - v1 * (2.0f / c1 * v1.dot(prev.normal));
+			tL = prev.tangent - v1 * (2.0f / c1 * v1.dot(prev.tangent));
 		}
-		m_samplePtsDirty = false;
+		const ngl::Vec3 v2 = frame.tangent - tL;
+		const ngl::Real c2 = v2.dot(v2);
+		frame.normal = c2 > 0.0f ? rL - v2 * (2.0f / c2 * v2.dot(rL)) : rL;
+		frame.normal.normalize();
+		frame.binormal = frame.tangent.cross(frame.normal);
 	}
-	return m_samplePts;
 }
 
-void BezierCurve::createVAO() noexcept
+ngl::Vec3 BezierCurve::getDerivative( const ngl::Real _value ) noexcept
 {
-  if(m_vaoCurve!=nullptr && m_vaoPoints!=nullptr)
-  {
-    m_vaoCurve->unbind();
-    m_vaoCurve->removeVAO();
-    m_vaoPoints->unbind();
-    m_vaoPoints->removeVAO();
-  }
+	const size_t n = m_cp.size();
+	if (n < 2)
+		return ngl::Vec3();
+	if (n == 4)
+		return BezierN<3>::derivative(m_cp.data(), _value);
+
+	// the hodograph is a curve of one degree less through (n-1) * (P[i+1] - P[i])
+	ngl::Vec3 stackPts[s_maxStackCPs];
+	ngl::Vec3 *pts = stackPts;
+	if (n > s_maxStackCPs) {
+		static thread_local std::vector<ngl::Vec3> scratch;
+		if (scratch.size() < n)
+			scratch.resize(n);
+		pts = scratch.data();
+	}
+	const ngl::Real degree = static_cast<ngl::Real>(n - 1);
+	for (size_t i = 0; i + 1 < n; ++i) {
+		pts[i] = (m_cp[i + 1] - m_cp[i]) * degree;
+	}
+	return deCasteljau(_value, pts, n - 1);
+}
 
-  m_vaoPoints=ngl::VAOFactory::createVAO("simpleVAO",GL_POINTS);
-  m_vaoPoints->bind();
-  std::vector <ngl::Vec3> points = m_cp;
-  m_vaoPoints->setData(ngl::SimpleVAO::VertexData(m_numCP*sizeof(ngl::Vec3),points[0].m_x));
-  m_vaoPoints->setNumIndices(m_numCP);
-  m_vaoPoints->setVertexAttributePointer(0,3,GL_FLOAT,0,0);
-  m_vaoPoints->unbind();
+ngl::Real BezierCurve::integrateSpeed(ngl::Real _t0, ngl::Real _t1) noexcept
+{
+	// 5 point Gauss-Legendre quadrature of |P'(t)|
+	static constexpr ngl::Real nodes[5] = {0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f};
+	static constexpr ngl::Real weights[5] = {0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f};
+	const ngl::Real half = 0.5f * (_t1 - _t0);
+	const ngl::Real mid = 0.5f * (_t1 + _t0);
+	ngl::Real sum = 0.0f;
+	for (int i = 0; i < 5; ++i) {
+		sum += weights[i] * getDerivative(mid + half * nodes[i]).length();
+	}
+	return sum * half;
+}
 
+void BezierCurve::buildArcLengthTable() noexcept
+{
+	const unsigned int segments = std::max(m_lod, 1u);
+	m_arcLengths.resize(segments + 1);
+	m_arcLengths[0] = 0.0f;
+	for (unsigned int i = 0; i < segments; ++i) {
+		const ngl::Real t0 = static_cast<ngl::Real>(i) / segments;
+		const ngl::Real t1 = static_cast<ngl::Real>(i + 1) / segments;
+		m_arcLengths[i + 1] = m_arcLengths[i] + integrateSpeed(t0, t1);
+	}
+	m_arcLengthsDirty = false;
+}
 
-  m_vaoCurve=ngl::VAOFactory::createVAO("simpleVAO",GL_LINE_STRIP);
-  m_vaoCurve->bind();
+ngl::Real BezierCurve::getLength() noexcept
+{
+	if (m_arcLengthsDirty) {
+		buildArcLengthTable();
+	}
+	return m_arcLengths.back();
+}
 
-  std::vector <ngl::Vec3> lines = getSamplePoints();
-  m_vaoCurve->setData(ngl::SimpleVAO::VertexData(m_lod*sizeof(ngl::Vec3),lines[0].m_x));
-  m_vaoCurve->setNumIndices(m_lod);
-  m_vaoCurve->setVertexAttributePointer(0,3,GL_FLOAT,0,0);
-  m_vaoCurve->unbind();
+ngl::Real BezierCurve::getLengthAtParameter(ngl::Real _value) noexcept
+{
+	if (m_arcLengthsDirty) {
+		buildArcLengthTable();
+	}
+	const size_t segments = m_arcLengths.size() - 1;
+	const ngl::Real t = std::clamp(_value, 0.0f, 1.0f);
+	const size_t i = std::min(static_cast<size_t>(t * segments), segments - 1);
+	const ngl::Real t0 = static_cast<ngl::Real>(i) / segments;
+	return m_arcLengths[i] + integrateSpeed(t0, t);
+}
 
+ngl::Real BezierCurve::getParameterAtLength(ngl::Real _length) noexcept
+{
+	if (m_arcLengthsDirty) {
+		buildArcLengthTable();
+	}
+	const size_t segments = m_arcLengths.size() - 1;
+	const ngl::Real total = m_arcLengths.back();
+	if (_length <= 0.0f || total <= 0.0f)
+		return 0.0f;
+	if (_length >= total)
+		return 1.0f;
+
+	// binary search for the segment containing _length
+	const auto it = std::upper_bound(m_arcLengths.begin(), m_arcLengths.end(), _length);
+	const size_t i = std::min(static_cast<size_t>(it - m_arcLengths.begin()) - 1, segments - 1);
+	const ngl::Real t0 = static_cast<ngl::Real>(i) / segments;
+	const ngl::Real t1 = static_cast<ngl::Real>(i + 1) / segments;
+	const ngl::Real segLength = m_arcLengths[i + 1] - m_arcLengths[i];
+
+	// linear guess inside the segment then Newton on L(t) - _length = 0, L'(t) = |P'(t)|
+	ngl::Real t = segLength > 0.0f ? t0 + (t1 - t0) * (_length - m_arcLengths[i]) / segLength : t0;
+	for (int iter = 0; iter < 4; ++iter) {
+		const ngl::Real error = m_arcLengths[i] + integrateSpeed(t0, t) - _length;
+		const ngl::Real speed = getDerivative(t).length();
+		if (speed <= 0.0f)
+			break;
+		t = std::clamp(t - error / speed, t0, t1);
+		if (std::abs(error) < 1e-6f * total)
+			break;
+	}
+	return t;
 }
 
-void BezierCurve::drawControlPoints()const noexcept
+void BezierCurve::setLOD(unsigned int lod) noexcept
 {
-  // Set color to red for control points
-  ngl::ShaderLib::setUniform("Colour", 1.0f, 0.0f, 0.0f, 1.0f);
-  
-  m_vaoPoints->bind();
-  m_vaoPoints->setMode(GL_POINTS);
-  m_vaoPoints->draw();
-  m_vaoPoints->unbind();
-  
-  // Reset color to white
-  ngl::ShaderLib::setUniform("Colour", 1.0f, 1.0f, 1.0f, 1.0f);
+	if(m_lod != lod){
+		m_lod = lod;
+		m_samplePtsDirty = true;
+		m_arcLengthsDirty = true;
+	}
 }
 
+void BezierCurve::setReanchorInterval(unsigned int _interval) noexcept
+{
+	if(m_reanchorInterval != _interval){
+		m_reanchorInterval = _interval;
+		m_samplePtsDirty = true;
+	}
+}
 
-void BezierCurve::drawHull()const noexcept
+void BezierCurve::setTessellationMode(TessellationMode _mode) noexcept
 {
-  m_vaoPoints->bind();
-  m_vaoPoints->setMode(GL_LINE_STRIP);
-  m_vaoPoints->draw();
-  m_vaoPoints->unbind();
- }
+	if(m_tessellationMode != _mode){
+		m_tessellationMode = _mode;
+		m_samplePtsDirty = true;
+	}
+}
 
+void BezierCurve::setTolerance(ngl::Real _tolerance) noexcept
+{
+	if(m_tolerance != _tolerance){
+		m_tolerance = _tolerance;
+		m_samplePtsDirty = true;
+	}
+}
 
-void BezierCurve::draw()  noexcept
+size_t BezierCurve::getVertexCount() noexcept
 {
-	m_vaoCurve->bind();
-	m_vaoCurve->draw();
-	m_vaoCurve->unbind();
+	if (m_samplePtsDirty) {
+		updateSamplePoints();
+	}
+	return m_samplePts.size();
 }
 
+namespace
+{
+	/// @brief the curve is flat enough when every interior control point lies within
+	/// _tolSq (squared) of the chord, the convex hull then bounds the chordal error
+	bool isFlat(const ngl::Vec3 *_cp, size_t _numCP, ngl::Real _tolSq) noexcept
+	{
+		const ngl::Vec3 &a = _cp[0];
+		const ngl::Vec3 chord = _cp[_numCP - 1] - a;
+		const ngl::Real chordLenSq = chord.lengthSquared();
+		for (size_t i = 1; i + 1 < _numCP; ++i) {
+			ngl::Vec3 ap = _cp[i] - a;
+			ngl::Real distSq;
+			if (chordLenSq > 0.0f) {
+				ngl::Real u = std::clamp(ap.dot(chord) / chordLenSq, 0.0f, 1.0f);
+				distSq = (ap - chord * u).lengthSquared();
+			} else {
+				distSq = ap.lengthSquared();
+			}
+			if (distSq > _tolSq)
+				return false;
+		}
+		return true;
+	}
+}
 
+void BezierCurve::subdivideAdaptive(const ngl::Vec3 *_cp, size_t _numCP, unsigned int _depth) noexcept
+{
+	if (_depth >= s_maxAdaptiveDepth || isFlat(_cp, _numCP, m_tolerance * m_tolerance)) {
+		m_samplePts.push_back(_cp[_numCP - 1]);
+		return;
+	}
+	// split at t = 0.5, the left half takes the first point of every deCasteljau
+	// level and the right half the last point
+	ngl::Vec3 pts[s_maxStackCPs];
+	ngl::Vec3 left[s_maxStackCPs];
+	ngl::Vec3 right[s_maxStackCPs];
+	std::copy(_cp, _cp + _numCP, pts);
+	left[0] = pts[0];
+	right[_numCP - 1] = pts[_numCP - 1];
+	for (size_t n = _numCP - 1, level = 1; n > 0; --n, ++level) {
+		for (size_t i = 0; i < n; ++i) {
+			pts[i] = lerp(0.5f, pts[i], pts[i + 1]);
+		}
+		left[level] = pts[0];
+		right[_numCP - 1 - level] = pts[n - 1];
+	}
+	subdivideAdaptive(left, _numCP, _depth + 1);
+	subdivideAdaptive(right, _numCP, _depth + 1);
+}
 
+void BezierCurve::updateSamplePoints() noexcept
+{
+	// the work behind getSamplePoints and getSampleView
+	FEATHER_TRACE_SCOPE("BezierCurve::updateSamplePoints");
+	if (m_tessellationMode == TessellationMode::ADAPTIVE && !m_cp.empty() && m_cp.size() <= s_maxStackCPs) {
+		// adaptive output includes both end points of the curve
+		m_samplePts.clear();
+		m_samplePts.push_back(m_cp.front());
+		if (m_cp.size() > 1) {
+			subdivideAdaptive(m_cp.data(), m_cp.size(), 0);
+		}
+	} else {
+		m_samplePts.resize(m_lod);
+		if (m_cp.size() == 4) {
+			// uniform steps on a cubic, forward differencing is three adds per sample
+			BezierN<3>::sampleUniform(m_cp.data(), 1.0f / m_lod, m_lod, m_samplePts.data(), m_reanchorInterval);
+		} else {
+			for(unsigned int i = 0; i < m_lod; ++i) {
+				ngl::Real t = static_cast<float>(i) / m_lod;
+				m_samplePts[i] = getPointOnCurve(t);
+			}
+		}
+	}
+	m_samplePtsDirty = false;
+}
 
+std::vector<ngl::Vec3> BezierCurve::getSamplePoints() noexcept
+{
+	if (m_samplePtsDirty) {
+		updateSamplePoints();
+	}
+	return m_samplePts;
+}
+
+std::span<const ngl::Vec3> BezierCurve::getSampleView() noexcept
+{
+	if (m_samplePtsDirty) {
+		updateSamplePoints();
+	}
+	return m_samplePts;
+}
 
+void BezierCurve::appendSamplePoints(std::vector<ngl::Vec3> &io_buffer)
+{
+	auto samples = getSampleView();
+	io_buffer.insert(io_buffer.end(), samples.begin(), samples.end());
+}
 
+void BezierCurve::setSamplePoints(const ngl::Vec3 *_pts, size_t _numPts) noexcept
+{
+	m_lod = static_cast<unsigned int>(_numPts);
+	m_samplePts.assign(_pts, _pts + _numPts);
+	m_samplePtsDirty = false;
+}
 
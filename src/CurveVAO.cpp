@@ -0,0 +1,91 @@
+/// @file CurveVAO.cpp
+/// @brief the GL side of a BezierCurve, persistent VAOs for its control points and samples
+
+#include "CurveVAO.h"
+#include "Curve.h"
+#include "VertexUpload.h"
+#include "Trace.h"
+#include "ngl/VAOFactory.h"
+#include "ngl/SimpleVAO.h"
+#include "ngl/ShaderLib.h"
+
+CurveVAO::~CurveVAO() noexcept
+{
+    if (m_vaoCurve != nullptr)
+    {
+        m_vaoCurve->unbind();
+        m_vaoCurve->removeVAO();
+    }
+    if (m_vaoPoints != nullptr)
+    {
+        m_vaoPoints->unbind();
+        m_vaoPoints->removeVAO();
+    }
+}
+
+void CurveVAO::upload(BezierCurve &_curve) noexcept
+{
+    upload(_curve.getCPs(), _curve.getSampleView());
+}
+
+void CurveVAO::upload(std::span<const ngl::Vec3> _cps, std::span<const ngl::Vec3> _samples) noexcept
+{
+    FEATHER_TRACE_SCOPE("CurveVAO::upload");
+    if (m_vaoPoints == nullptr)
+    {
+        m_vaoPoints = ngl::VAOFactory::createVAO("simpleVAO", GL_POINTS);
+        m_pointsCapacity = 0;
+    }
+    m_vaoPoints->bind();
+    streamPoints(*m_vaoPoints, m_pointsCapacity, _cps.data(), _cps.size());
+    m_vaoPoints->unbind();
+    m_numPoints = _cps.size();
+
+    if (m_vaoCurve == nullptr)
+    {
+        m_vaoCurve = ngl::VAOFactory::createVAO("simpleVAO", GL_LINE_STRIP);
+        m_curveCapacity = 0;
+    }
+    m_vaoCurve->bind();
+    streamPoints(*m_vaoCurve, m_curveCapacity, _samples.data(), _samples.size());
+    m_vaoCurve->unbind();
+    m_numSamples = _samples.size();
+}
+
+void CurveVAO::draw() const noexcept
+{
+    if (empty())
+        return;
+    m_vaoCurve->bind();
+    m_vaoCurve->draw();
+    m_vaoCurve->unbind();
+    recordDraw(m_numSamples);
+}
+
+void CurveVAO::drawControlPoints() const noexcept
+{
+    if (m_vaoPoints == nullptr)
+        return;
+    // Set color to red for control points
+    ngl::ShaderLib::setUniform("Colour", 1.0f, 0.0f, 0.0f, 1.0f);
+
+    m_vaoPoints->bind();
+    m_vaoPoints->setMode(GL_POINTS);
+    m_vaoPoints->draw();
+    m_vaoPoints->unbind();
+    recordDraw(m_numPoints);
+
+    // Reset color to white
+    ngl::ShaderLib::setUniform("Colour", 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void CurveVAO::drawHull() const noexcept
+{
+    if (m_vaoPoints == nullptr)
+        return;
+    m_vaoPoints->bind();
+    m_vaoPoints->setMode(GL_LINE_STRIP);
+    m_vaoPoints->draw();
+    m_vaoPoints->unbind();
+    recordDraw(m_numPoints);
+}
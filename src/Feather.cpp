@@ -1,44 +1,172 @@
 #include "Feather.h"
 
-#include <qconfig.h>
-
 #include "Curve.h"
+#include "BarbBatch.h"
+#include "FeatherGeometry.h"
+#include "Trace.h"
+#include <chrono>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+    /// @brief stages rebuilt when a stage is dirtied, itself plus everything downstream
+    unsigned int stageClosure(FeatherStage stage) noexcept
+    {
+        constexpr unsigned int rachis = static_cast<unsigned int>(FeatherStage::RACHIS);
+        constexpr unsigned int outlines = static_cast<unsigned int>(FeatherStage::OUTLINES);
+        constexpr unsigned int templateBarbs = static_cast<unsigned int>(FeatherStage::TEMPLATE_BARBS);
+        constexpr unsigned int allBarbs = static_cast<unsigned int>(FeatherStage::ALL_BARBS);
+        switch (stage)
+        {
+            case FeatherStage::RACHIS : return rachis | outlines | templateBarbs | allBarbs;
+            case FeatherStage::OUTLINES : return outlines | templateBarbs | allBarbs;
+            case FeatherStage::TEMPLATE_BARBS : return templateBarbs;
+            case FeatherStage::ALL_BARBS : return allBarbs;
+        }
+        return 0;
+    }
+}
+
+void Feather::markDirty(FeatherStage stage) noexcept
+{
+    m_dirtyStages |= stageClosure(stage);
+}
+
+bool Feather::isStageDirty(FeatherStage stage) const noexcept
+{
+    return (m_dirtyStages & static_cast<unsigned int>(stage)) != 0;
+}
 
 void Feather::setSampleNum(const int _num) noexcept
 {
-    m_sample = _num;
+    if (m_sample != static_cast<unsigned int>(_num)) {
+        m_sample = _num;
+        // outline LOD is derived from the rachis sample count as well
+        markDirty(FeatherStage::RACHIS);
+    }
 }
 
 void Feather::setF0(const ngl::Real _f0) noexcept
 {
-    m_F0 = _f0;
+    if (m_F0 != _f0) {
+        m_F0 = _f0;
+        markDirty(FeatherStage::OUTLINES);
+    }
 }
 
 void Feather::setFn(const ngl::Real _fn) noexcept
 {
-    m_Fn = _fn;
+    if (m_Fn != _fn) {
+        m_Fn = _fn;
+        markDirty(FeatherStage::ALL_BARBS);
+    }
 }
 
 // ===== Barb Generation Methods =====
 void Feather::setNumBarbs(unsigned int numBarbs)
 {
-    m_numBarbs = numBarbs;
+    if (m_numBarbs != numBarbs) {
+        m_numBarbs = numBarbs;
+        markDirty(FeatherStage::ALL_BARBS);
+    }
 }
 
 void Feather::setBarbsOutlineFactor(ngl::Real left_factor, ngl::Real right_factor)
 {
-    m_leftBarbOutlineFactor = left_factor;
-    m_rightBarbOutlineFactor = right_factor;
+    if (m_leftBarbOutlineFactor != left_factor || m_rightBarbOutlineFactor != right_factor) {
+        m_leftBarbOutlineFactor = left_factor;
+        m_rightBarbOutlineFactor = right_factor;
+        // only the template barbs end on these outline positions
+        markDirty(FeatherStage::TEMPLATE_BARBS);
+    }
 }
 
 void Feather::setFb(const ngl::Real _fb) noexcept
 {
-    m_Fb = _fb;
+    if (m_Fb != _fb) {
+        m_Fb = _fb;
+        markDirty(FeatherStage::TEMPLATE_BARBS);
+        markDirty(FeatherStage::ALL_BARBS);
+    }
 }
 
 void Feather::setBarbLOD(unsigned int lod)
 {
-    m_numBarbules = lod;
+    if (m_numBarbules != lod) {
+        m_numBarbules = lod;
+        markDirty(FeatherStage::TEMPLATE_BARBS);
+        markDirty(FeatherStage::ALL_BARBS);
+    }
+}
+
+void Feather::setBarbSpacing(BarbSpacing spacing) noexcept
+{
+    if (m_barbSpacing != spacing) {
+        m_barbSpacing = spacing;
+        markDirty(FeatherStage::ALL_BARBS);
+    }
+}
+
+BarbShape Feather::getBarbShape() const noexcept
+{
+    BarbShape shape;
+    shape.fb = m_Fb;
+    shape.p1XFactor = m_p1XFactor;
+    shape.p1YFactor = m_p1YFactor;
+    shape.p2XFactor = m_p2XFactor;
+    shape.p2YFactor = m_p2YFactor;
+    shape.lod = m_numBarbules;
+    return shape;
+}
+
+FeatherGeometry Feather::getGeometry() const
+{
+    FeatherGeometry geometry;
+    auto samples = [](BezierCurve* curve) {
+        return curve ? curve->getSampleView() : std::span<const ngl::Vec3>();
+    };
+    geometry.rachis = samples(m_rachis.get());
+    geometry.leftOutline = samples(m_leftOutline.get());
+    geometry.rightOutline = samples(m_rightOutline.get());
+    geometry.leftTemplateBarb = samples(m_leftBarb.get());
+    geometry.rightTemplateBarb = samples(m_rightBarb.get());
+    geometry.numBarbs = m_barbs.numBarbs();
+    geometry.barbLOD = m_barbs.lod();
+    if (!m_barbs.empty()) {
+        geometry.barbRoots = m_barbRoots;
+        geometry.leftBarbTips = m_barbLeftTips;
+        geometry.rightBarbTips = m_barbRightTips;
+        geometry.barbSamples = m_barbs.samples();
+    }
+    return geometry;
+}
+
+void Feather::setOutlineSymmetric(bool symmetric)
+{
+    if (m_outlineSymmetric != symmetric) {
+        m_outlineSymmetric = symmetric;
+        markDirty(FeatherStage::OUTLINES);
+    }
+}
+
+void Feather::computeBarbControlPoints(const ngl::Vec3& p0,
+                                       const ngl::Vec3& p3,
+                                       ngl::Real p1XFactor,
+                                       ngl::Real p1YFactor,
+                                       ngl::Real p2XFactor,
+                                       ngl::Real p2YFactor,
+                                       bool isLeftSide,
+                                       ngl::Vec3 o_cp[4]) const noexcept
+{
+    BarbShape shape = getBarbShape();
+    shape.p1XFactor = p1XFactor;
+    shape.p1YFactor = p1YFactor;
+    shape.p2XFactor = p2XFactor;
+    shape.p2YFactor = p2YFactor;
+    barbControlPoints(p0, p3, shape, isLeftSide, o_cp);
 }
 
 std::unique_ptr<BezierCurve> Feather::GenerateSingleBarb(const ngl::Vec3& p0,
@@ -49,34 +177,14 @@ std::unique_ptr<BezierCurve> Feather::GenerateSingleBarb(const ngl::Vec3& p0,
                                                         ngl::Real p2YFactor,
                                                         bool isLeftSide) const
 {
-    // Calculate distance between p0 and p3
-    ngl::Real d = (p3 - p0).length();
-
-    // Calculate p1 position based on factors
-    // For left side: p1.x = p0.x + v1 (where -Fb*d < v1 < 0)
-    // For right side: p1.x = p0.x + v1 (where 0 < v1 < Fb*d) - inverted
-    // p1.y = p0.y + v2 (where -Fb*d < v2 < Fb*d) - same for both sides
-    ngl::Real v1, v3;
-    if (isLeftSide) {
-        v1 = -m_Fb * d * p1XFactor; // Maps 0-1 to (-Fb*d, 0) for left
-        v3 = m_Fb * d * p2XFactor;  // Maps 0-1 to (0, Fb*d) for left
-    } else {
-        v1 = m_Fb * d * p1XFactor;  // Maps 0-1 to (0, Fb*d) for right - inverted
-        v3 = -m_Fb * d * p2XFactor; // Maps 0-1 to (-Fb*d, 0) for right - inverted
-    }
-    
-    ngl::Real v2 = (2.0f * p1YFactor - 1.0f) * m_Fb * d; // Maps 0-1 to (-Fb*d, Fb*d)
-    ngl::Real v4 = (2.0f * p2YFactor - 1.0f) * m_Fb * d; // Maps 0-1 to (-Fb*d, Fb*d)
-
-    ngl::Vec3 p1(p0.m_x + v1, p0.m_y + v2, p0.m_z);
-    ngl::Vec3 p2(p3.m_x + v3, p3.m_y + v4, p0.m_z);
+    ngl::Vec3 cp[4];
+    computeBarbControlPoints(p0, p3, p1XFactor, p1YFactor, p2XFactor, p2YFactor, isLeftSide, cp);
 
     // Create and return the barb curve
     auto barb = std::make_unique<BezierCurve>();
-    barb->addPoint(p0);
-    barb->addPoint(p1);
-    barb->addPoint(p2);
-    barb->addPoint(p3);
+    for (const auto& p : cp) {
+        barb->addPoint(p);
+    }
     barb->setLOD(m_numBarbules);
 
     return barb;
@@ -87,13 +195,18 @@ void Feather::setBarbControlFactors(ngl::Real p1XFactor,
                                    ngl::Real p2XFactor,
                                    ngl::Real p2YFactor)
 {
-    m_p1XFactor = p1XFactor;
-    m_p1YFactor = p1YFactor;
-    m_p2XFactor = p2XFactor;
-    m_p2YFactor = p2YFactor;
+    if (m_p1XFactor != p1XFactor || m_p1YFactor != p1YFactor ||
+        m_p2XFactor != p2XFactor || m_p2YFactor != p2YFactor) {
+        m_p1XFactor = p1XFactor;
+        m_p1YFactor = p1YFactor;
+        m_p2XFactor = p2XFactor;
+        m_p2YFactor = p2YFactor;
+        markDirty(FeatherStage::TEMPLATE_BARBS);
+        markDirty(FeatherStage::ALL_BARBS);
+    }
 }
 
-void Feather::generateTemplateBarbs() const
+void Feather::generateTemplateBarbs()
 {
     // Ensure rachis and outlines exist
     if (!m_rachis) {
@@ -101,34 +214,22 @@ void Feather::generateTemplateBarbs() const
     }
     if (!m_leftOutline || !m_rightOutline) {
         // Need to generate outlines first
+        m_leftBarb.reset();
+        m_rightBarb.reset();
         return;
     }
-    
-    // Calculate p0 (starting point on rachis at middle position of barb region)
-    // Barb region starts at m_F0 and goes to 1.0
-    // Middle position = m_F0 + (1.0 - m_F0) * 0.5
-    ngl::Real middleFactor = m_F0 + (1.0f - m_F0) * 0.5f;
-    ngl::Vec3 p0 = m_rachis->getPointOnCurve(middleFactor);
-    
-    // Calculate p3 for left barb (end point on left outline)
-    ngl::Vec3 leftP3 = m_leftOutline->getPointOnCurve(m_leftBarbOutlineFactor);
-    
-    // Calculate p3 for right barb (end point on right outline)  
-    ngl::Vec3 rightP3 = m_rightOutline->getPointOnCurve(m_rightBarbOutlineFactor);
-    
-    // Generate left template barb using member variables
-    m_leftBarb = GenerateSingleBarb(p0, leftP3, m_p1XFactor, m_p1YFactor, m_p2XFactor, m_p2YFactor, true);
-    
-    // Generate right template barb using member variables
-    m_rightBarb = GenerateSingleBarb(p0, rightP3, m_p1XFactor, m_p1YFactor, m_p2XFactor, m_p2YFactor, false);
-
+    if (!m_leftBarb) {
+        m_leftBarb = std::make_unique<BezierCurve>();
+        m_rightBarb = std::make_unique<BezierCurve>();
+    }
+    buildTemplateBarbs(getParams(), *m_rachis, *m_leftOutline, *m_rightOutline, *m_leftBarb, *m_rightBarb);
 }
 
-void Feather::generateAllBarbs() const
+void Feather::generateAllBarbs()
 {
-    // Clear existing barb collections
-    m_leftBarbs.clear();
-    m_rightBarbs.clear();
+    FEATHER_TRACE_SCOPE("Feather::generateAllBarbs");
+    // Clear existing barbs, the buffer keeps its memory for the next generation
+    m_barbs.clear();
     
     // Ensure rachis and outlines exist
     if (!m_rachis) {
@@ -138,65 +239,88 @@ void Feather::generateAllBarbs() const
         // Need to generate outlines first
         return;
     }
-    
-    // Calculate barb distribution along rachis
-    // Barbs start at F0 position and distribute towards tip (but not all the way to 1.0)
-    ngl::Real barbStart = m_F0;
-    ngl::Real barbEnd = m_Fn; // Stop before the very tip
-    ngl::Real barbRegionLength = std::clamp(barbEnd - barbStart, 0.0f, 1.0f);
-    
-    for (unsigned i = 0; i < m_numBarbs; ++i) {
-        // Position along rachis
-        const ngl::Real tRachis = barbStart +
-            (static_cast<ngl::Real>(i) / static_cast<ngl::Real>(m_numBarbs - 1)) *
-            (barbEnd - barbStart);
-
-        // Map to outline position
-        const ngl::Real tOutline = m_outlineMappingStart +
-            ((tRachis - barbStart) / (barbRegionLength)) *
-            (m_outlineMappingEnd - m_outlineMappingStart);
-
-        // Get points
-        const ngl::Vec3 p0 = m_rachis->getPointOnCurve(tRachis);
-        const ngl::Vec3 leftP3 = m_leftOutline->getPointOnCurve(tOutline);
-        const ngl::Vec3 rightP3 = m_rightOutline->getPointOnCurve(tOutline);
-
-        // Generate left barb
-        if (auto leftBarb = GenerateSingleBarb(p0, leftP3,
-            m_p1XFactor, m_p1YFactor, m_p2XFactor, m_p2YFactor, true)) {
-            leftBarb->setLOD(m_numBarbules);
-            leftBarb->createVAO();
-            m_leftBarbs.push_back(std::move(leftBarb));
-            }
-
-        // Generate right barb
-        if (auto rightBarb = GenerateSingleBarb(p0, rightP3,
-            m_p1XFactor, m_p1YFactor, m_p2XFactor, m_p2YFactor, false)) {
-            rightBarb->setLOD(m_numBarbules);
-            rightBarb->createVAO();
-            m_rightBarbs.push_back(std::move(rightBarb));
-            }
-    }
-}
-
-void Feather::ensureRachisExists() const
+
+    // The basis table is shared by all barbs and only rebuilt when the LOD has changed
+    if (!m_barbBasis.matches(3, m_numBarbules)) {
+        m_barbBasis.rebuild(3, m_numBarbules);
+    }
+
+    m_barbTRachis.resize(m_numBarbs);
+    m_barbTLeftOutline.resize(m_numBarbs);
+    m_barbTRightOutline.resize(m_numBarbs);
+    m_barbRoots.resize(m_numBarbs);
+    m_barbLeftTips.resize(m_numBarbs);
+    m_barbRightTips.resize(m_numBarbs);
+    m_barbs.resize(m_numBarbs, m_numBarbules);
+
+    BarbTargets barbs;
+    barbs.tRachis = m_barbTRachis;
+    barbs.tLeftOutline = m_barbTLeftOutline;
+    barbs.tRightOutline = m_barbTRightOutline;
+    barbs.roots = m_barbRoots;
+    barbs.leftTips = m_barbLeftTips;
+    barbs.rightTips = m_barbRightTips;
+    barbs.samples = m_barbs.samples();
+    buildBarbs(getParams(), *m_rachis, *m_leftOutline, *m_rightOutline, m_barbBasis, m_barbs.controlPoints(),
+               barbs, threadCount());
+}
+
+void Feather::computeBarbParameters(std::vector<ngl::Real>& o_tRachis,
+                                    std::vector<ngl::Real>& o_tLeftOutline,
+                                    std::vector<ngl::Real>& o_tRightOutline) const
+{
+    o_tRachis.resize(m_numBarbs);
+    o_tLeftOutline.resize(m_numBarbs);
+    o_tRightOutline.resize(m_numBarbs);
+
+    barbParameters(getParams(), *m_rachis, *m_leftOutline, *m_rightOutline,
+                   o_tRachis, o_tLeftOutline, o_tRightOutline, threadCount());
+}
+
+void Feather::setBarbJitter(ngl::Real jitter, std::uint32_t seed) noexcept
+{
+    jitter = std::clamp(jitter, 0.0f, 1.0f);
+    if (m_barbJitter != jitter || m_seed != seed) {
+        m_barbJitter = jitter;
+        m_seed = seed;
+        markDirty(FeatherStage::ALL_BARBS);
+    }
+}
+
+void Feather::setNumThreads(unsigned int numThreads) noexcept
+{
+    m_numThreads = numThreads;
+}
+
+int Feather::threadCount() const noexcept
+{
+#ifdef _OPENMP
+    return m_numThreads != 0 ? static_cast<int>(m_numThreads) : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+void Feather::ensureRachisExists()
 {
     if (!m_rachis) {
         m_rachis = std::make_unique<BezierCurve>();
     }
 }
 
-void Feather::GenerateRachis(const ngl::Vec3& p0, const ngl::Vec3& p1, const ngl::Vec3& p2, const ngl::Vec3& p3) const
+void Feather::GenerateRachis(const ngl::Vec3& p0, const ngl::Vec3& p1, const ngl::Vec3& p2, const ngl::Vec3& p3)
 {
     ensureRachisExists();
-    m_rachis->addPoint(p0);
-    m_rachis->addPoint(p1);
-    m_rachis->addPoint(p2);
-    m_rachis->addPoint(p3);
-    m_rachis->setLOD(m_sample);
+    // The points may come from the caller rather than the members
+    FeatherParams params = getParams();
+    params.rachisP0 = p0;
+    params.rachisP1 = p1;
+    params.rachisP2 = p2;
+    params.rachisP3 = p3;
+    buildRachis(params, *m_rachis);
 }
 
-void Feather::generateRachis() const
+void Feather::generateRachis()
 {
     GenerateRachis(m_rachisP0, m_rachisP1, m_rachisP2, m_rachisP3);
 }
@@ -205,10 +329,14 @@ void Feather::generateRachis() const
 void Feather::setRachisControlPoints(const ngl::Vec3& p0, const ngl::Vec3& p1, 
                                     const ngl::Vec3& p2, const ngl::Vec3& p3)
 {
+    if (m_rachisP0 == p0 && m_rachisP1 == p1 && m_rachisP2 == p2 && m_rachisP3 == p3) {
+        return;
+    }
     m_rachisP0 = p0;
     m_rachisP1 = p1;
     m_rachisP2 = p2;
     m_rachisP3 = p3;
+    markDirty(FeatherStage::RACHIS);
 }
 
 std::vector<ngl::Vec3> Feather::getRachisControlPoints() const
@@ -216,6 +344,15 @@ std::vector<ngl::Vec3> Feather::getRachisControlPoints() const
     return {m_rachisP0, m_rachisP1, m_rachisP2, m_rachisP3};
 }
 
+void Feather::getRachisFrames(std::vector<CurveFrame>& o_frames) const
+{
+    if (!m_rachis) {
+        o_frames.clear();
+        return;
+    }
+    m_rachis->getSampleFrames(o_frames);
+}
+
 ngl::Vec3 Feather::getStartPointOnRachis(ngl::Real _t)
 {
     return m_rachis->getPointOnCurve(_t);
@@ -226,89 +363,69 @@ void Feather::setOutlineControlPoints(const ngl::Vec3 &leftP1, const ngl::Vec3 &
                                      const ngl::Vec3 &rightP1, const ngl::Vec3 &rightP2,
                                      const ngl::Vec3 &endP3)
 {
+    if (!m_outlineSymmetric && m_outlineP1 == leftP1 && m_outlineP2 == leftP2 &&
+        m_rightOutlineP1 == rightP1 && m_rightOutlineP2 == rightP2 && m_outlineP3 == endP3) {
+        return;
+    }
     m_outlineP1 = leftP1;
     m_outlineP2 = leftP2;
     m_rightOutlineP1 = rightP1;
     m_rightOutlineP2 = rightP2;
     m_outlineP3 = endP3;
     m_outlineSymmetric = false;
+    markDirty(FeatherStage::OUTLINES);
 }
 
 void Feather::setSymmetricOutlineControlPoints(const ngl::Vec3 &p1, const ngl::Vec3 &p2, const ngl::Vec3 &p3)
 {
+    if (m_outlineSymmetric && m_outlineP1 == p1 && m_outlineP2 == p2 && m_outlineP3 == p3) {
+        return;
+    }
     m_outlineP1 = p1;
     m_outlineP2 = p2;
     m_outlineP3 = p3;
     m_outlineSymmetric = true;
+    markDirty(FeatherStage::OUTLINES);
 }
 
 void Feather::setOutlineMappingRange(ngl::Real start, ngl::Real end) noexcept {
+    const ngl::Real previousStart = m_outlineMappingStart;
+    const ngl::Real previousEnd = m_outlineMappingEnd;
     m_outlineMappingStart = std::clamp(start, 0.0f, 1.0f);
     m_outlineMappingEnd = std::clamp(end, 0.0f, 1.0f);
     // make sure end >= start
     if(m_outlineMappingEnd < m_outlineMappingStart) {
         m_outlineMappingEnd = m_outlineMappingStart;
     }
+    if (m_outlineMappingStart != previousStart || m_outlineMappingEnd != previousEnd) {
+        markDirty(FeatherStage::ALL_BARBS);
+    }
 }
 
 void Feather::GenerateOutlines( ngl::Vec3 &p1, ngl::Vec3 &p2, ngl::Vec3 &p3)
 {
+    FEATHER_TRACE_SCOPE("Feather::GenerateOutlines");
     if (!m_rachis) {
         generateRachis();
     }
 
-    std::vector<ngl::Vec3> rachisPts = m_rachis->getSamplePoints();
-    if (rachisPts.empty()) return;
-
-    // Get starting point on rachis (at F0 position)
-    int startIndex = static_cast<int>(m_F0 * (m_sample - 1));
-    if (startIndex >= static_cast<int>(rachisPts.size())) startIndex = rachisPts.size() - 1;
-    ngl::Vec3 p0 = rachisPts[startIndex];
-    m_outlineP0 = p0;
-
-    // Calculate LOD for outlines
-    unsigned int outlineLOD = static_cast<unsigned int>(m_sample * (1.0f - m_F0));
-
-    // Create left outline
-    m_leftOutline = std::make_unique<BezierCurve>();
-    m_rightOutline = std::make_unique<BezierCurve>();
-
-    if (m_outlineSymmetric) {
-        // Symmetrical outlines - mirror left side to right side
-        ngl::Vec3 leftP1 = p1;
-        ngl::Vec3 leftP2 = p2;
-        ngl::Vec3 rightP1(-p1.m_x, p1.m_y, p1.m_z);  // Mirror X coordinate
-        ngl::Vec3 rightP2(-p2.m_x, p2.m_y, p2.m_z);  // Mirror X coordinate
-
-        // Add points to left outline
-        m_leftOutline->addPoint(p0);
-        m_leftOutline->addPoint(leftP1);
-        m_leftOutline->addPoint(leftP2);
-        m_leftOutline->addPoint(p3);
-
-        // Add points to right outline
-        m_rightOutline->addPoint(p0);
-        m_rightOutline->addPoint(rightP1);
-        m_rightOutline->addPoint(rightP2);
-        m_rightOutline->addPoint(p3);
-    } else {
-        // Separate control points for left and right outlines
-        // Add points to left outline
-        m_leftOutline->addPoint(p0);
-        m_leftOutline->addPoint(m_outlineP1);
-        m_leftOutline->addPoint(m_outlineP2);
-        m_leftOutline->addPoint(p3);
-
-        // Add points to right outline
-        m_rightOutline->addPoint(p0);
-        m_rightOutline->addPoint(m_rightOutlineP1);
-        m_rightOutline->addPoint(m_rightOutlineP2);
-        m_rightOutline->addPoint(p3);
+    if (!m_leftOutline) {
+        m_leftOutline = std::make_unique<BezierCurve>();
+        m_rightOutline = std::make_unique<BezierCurve>();
     }
 
-    // Set LOD for both outlines
-    m_leftOutline->setLOD(outlineLOD);
-    m_rightOutline->setLOD(outlineLOD);
+    // The outline points may come from the caller rather than the members
+    FeatherParams params = getParams();
+    params.outlineP1 = p1;
+    params.outlineP2 = p2;
+    params.outlineP3 = p3;
+    if (buildOutlines(params, *m_rachis, *m_leftOutline, *m_rightOutline)) {
+        m_outlineP0 = m_leftOutline->getCPs()[0];
+    } else {
+        // no rachis samples to start from, so no outlines either
+        m_leftOutline.reset();
+        m_rightOutline.reset();
+    }
 }
 
 void Feather::generateOutlines()
@@ -316,85 +433,123 @@ void Feather::generateOutlines()
        GenerateOutlines(m_outlineP1, m_outlineP2, m_outlineP3);
 }
 
-void Feather::drawRachis() const
+unsigned int Feather::generate()
 {
-    if (m_rachis) {
-        m_rachis->draw();
+    FEATHER_TRACE_SCOPE("Feather::generate");
+    const unsigned int rebuilt = m_dirtyStages;
+    m_stageTimes = FeatherStageTimes();
+    auto start = std::chrono::steady_clock::now();
+    // milliseconds since the previous lap
+    auto lap = [&start]() {
+        const auto now = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(now - start).count();
+        start = now;
+        return ms;
+    };
+
+    if (isStageDirty(FeatherStage::RACHIS)) {
+        generateRachis();
+        m_stageTimes.rachisMs = lap();
     }
-}
 
-void Feather::drawOutlines() const
-{
-    if (m_leftOutline && m_rightOutline)
-    {
-        m_leftOutline->draw();
-        m_rightOutline->draw();
+    if (isStageDirty(FeatherStage::OUTLINES)) {
+        lap();
+        generateOutlines();
+        m_stageTimes.outlinesMs = lap();
     }
-}
 
-void Feather::drawBarb() const
-{
-    if (m_leftBarb && m_rightBarb)
-    {
-        m_leftBarb->drawControlPoints();
-        m_leftBarb->draw();
-        m_rightBarb->drawControlPoints();
-        m_rightBarb->draw();
+    if (isStageDirty(FeatherStage::TEMPLATE_BARBS)) {
+        lap();
+        generateTemplateBarbs();
+        m_stageTimes.templateBarbsMs = lap();
     }
-}
 
-void Feather::drawAllBarbs() const
-{
-    // Draw all left barbs
-    for (const auto& barb : m_leftBarbs) {
-        if (barb) {
-            barb->draw();
-        }
+    if (isStageDirty(FeatherStage::ALL_BARBS)) {
+        lap();
+        // Generate full feather barbs
+        generateAllBarbs();
+        m_stageTimes.allBarbsMs = lap();
     }
-    
-    // Draw all right barbs
-    for (const auto& barb : m_rightBarbs) {
-        if (barb) {
-            barb->draw();
+
+    // Fill the lazy sample caches here so uploading on the GL thread only copies
+    for (BezierCurve* curve : {m_rachis.get(), m_leftOutline.get(), m_rightOutline.get(),
+                               m_leftBarb.get(), m_rightBarb.get()}) {
+        if (curve) {
+            curve->getSampleView();
         }
     }
-}
-
 
+    m_dirtyStages = 0;
+    return rebuilt;
+}
 
-void Feather::update()
+FeatherParams Feather::getParams() const
 {
-    m_rachis.reset();
-    generateRachis();
-    m_rachis->createVAO();
-
-    m_leftOutline.reset();
-    m_rightOutline.reset();
-    generateOutlines();
-    m_leftOutline->createVAO();
-    m_rightOutline->createVAO();
-
-    m_leftBarb.reset();
-    m_rightBarb.reset();
-    generateTemplateBarbs();
-    m_leftBarb->createVAO();
-    m_rightBarb->createVAO();
-    
-    // Generate full feather barbs
-    generateAllBarbs();
+    FeatherParams params;
+    params.rachisP0 = m_rachisP0;
+    params.rachisP1 = m_rachisP1;
+    params.rachisP2 = m_rachisP2;
+    params.rachisP3 = m_rachisP3;
+    params.sampleNum = m_sample;
+    params.outlineSymmetric = m_outlineSymmetric;
+    params.outlineP1 = m_outlineP1;
+    params.outlineP2 = m_outlineP2;
+    params.outlineP3 = m_outlineP3;
+    params.rightOutlineP1 = m_rightOutlineP1;
+    params.rightOutlineP2 = m_rightOutlineP2;
+    params.f0 = m_F0;
+    params.fn = m_Fn;
+    params.numBarbs = m_numBarbs;
+    params.barbLOD = m_numBarbules;
+    params.barbSpacing = m_barbSpacing;
+    params.outlineMappingStart = m_outlineMappingStart;
+    params.outlineMappingEnd = m_outlineMappingEnd;
+    params.fb = m_Fb;
+    params.p1XFactor = m_p1XFactor;
+    params.p1YFactor = m_p1YFactor;
+    params.p2XFactor = m_p2XFactor;
+    params.p2YFactor = m_p2YFactor;
+    params.leftBarbOutlineFactor = m_leftBarbOutlineFactor;
+    params.rightBarbOutlineFactor = m_rightBarbOutlineFactor;
+    params.barbJitter = m_barbJitter;
+    params.seed = m_seed;
+    params.showOutlines = m_showOutlines;
+    return params;
 }
 
-
-void Feather::draw() const
+void Feather::setParams(const FeatherParams& params)
 {
-    drawRachis();
-    if (m_showOutlines) {
-        drawOutlines();
+    setRachisControlPoints(params.rachisP0, params.rachisP1, params.rachisP2, params.rachisP3);
+    setSampleNum(static_cast<int>(params.sampleNum));
+    if (params.outlineSymmetric) {
+        setSymmetricOutlineControlPoints(params.outlineP1, params.outlineP2, params.outlineP3);
+        // unused while symmetric, kept so getParams gives back what was set
+        m_rightOutlineP1 = params.rightOutlineP1;
+        m_rightOutlineP2 = params.rightOutlineP2;
+    } else {
+        setOutlineControlPoints(params.outlineP1, params.outlineP2,
+                                params.rightOutlineP1, params.rightOutlineP2, params.outlineP3);
     }
-    drawAllBarbs();
+    setF0(params.f0);
+    setFn(params.fn);
+    setNumBarbs(params.numBarbs);
+    setBarbLOD(params.barbLOD);
+    setBarbSpacing(params.barbSpacing);
+    setOutlineMappingRange(params.outlineMappingStart, params.outlineMappingEnd);
+    setFb(params.fb);
+    setBarbControlFactors(params.p1XFactor, params.p1YFactor, params.p2XFactor, params.p2YFactor);
+    setBarbsOutlineFactor(params.leftBarbOutlineFactor, params.rightBarbOutlineFactor);
+    setBarbJitter(params.barbJitter, params.seed);
+    setShowOutlines(params.showOutlines);
 }
 
-
-
-
-
+unsigned int Feather::changedStages(const FeatherParams& from, const FeatherParams& to)
+{
+    // Replaying both snapshots through the setters keeps a single definition of
+    // which parameter feeds which stage, no geometry is built
+    Feather feather;
+    feather.setParams(from);
+    feather.m_dirtyStages = 0;
+    feather.setParams(to);
+    return feather.m_dirtyStages;
+}
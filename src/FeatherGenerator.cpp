@@ -0,0 +1,180 @@
+/// @file FeatherGenerator.cpp
+/// @brief builds feather geometry on a worker thread from posted parameter snapshots
+
+#include "FeatherGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+FeatherGenerator::FeatherGenerator()
+    : m_back(std::make_unique<Feather>()), m_ready(std::make_unique<Feather>())
+{
+    // started last so every member is ready before the worker reads it
+    m_worker = std::thread(&FeatherGenerator::run, this);
+}
+
+FeatherGenerator::~FeatherGenerator()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    m_worker.join();
+}
+
+void FeatherGenerator::post(const FeatherParams &_params)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending)
+            ++m_dropped;
+        m_pending = _params;
+    }
+    m_wake.notify_one();
+}
+
+bool FeatherGenerator::takeResult(std::unique_ptr<Feather> &io_front)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasResult)
+        return false;
+    // the old front may be null on the first call, the worker replaces it
+    std::swap(io_front, m_ready);
+    m_hasResult = false;
+    return true;
+}
+
+void FeatherGenerator::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_pending && !m_busy; });
+}
+
+void FeatherGenerator::setOnReady(std::function<void()> _onReady)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onReady = std::move(_onReady);
+}
+
+std::size_t FeatherGenerator::droppedRequests() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+void FeatherGenerator::setNumThreads(unsigned int _numThreads)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numThreads = _numThreads;
+}
+
+void FeatherGenerator::setProgressive(const ProgressiveSettings &_settings)
+{
+    ProgressiveSettings settings = _settings;
+    std::vector<float> &steps = settings.steps;
+    steps.erase(std::remove_if(steps.begin(), steps.end(), [](float _step) { return !(_step > 0.0f); }), steps.end());
+    for (float &step : steps)
+        step = std::min(step, 1.0f);
+    std::sort(steps.begin(), steps.end());
+    steps.erase(std::unique(steps.begin(), steps.end()), steps.end());
+    if (steps.empty() || steps.back() < 1.0f)
+        steps.push_back(1.0f);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_progressive = std::move(settings);
+}
+
+FeatherParams FeatherGenerator::scaleDetail(const FeatherParams &_params, float _detail)
+{
+    FeatherParams scaled = _params;
+    if (_detail < 1.0f)
+    {
+        scaled.numBarbs = std::max(1u, static_cast<unsigned int>(std::lround(_params.numBarbs * _detail)));
+        scaled.barbLOD = std::max(2u, static_cast<unsigned int>(std::lround(_params.barbLOD * _detail)));
+    }
+    return scaled;
+}
+
+std::size_t FeatherGenerator::previewStep(const FeatherParams &_params) const
+{
+    const std::vector<float> &steps = m_progressive.steps;
+    // nothing measured yet, start from the cheapest step
+    if (m_msPerSample <= 0.0)
+        return 0;
+    for (std::size_t i = steps.size(); i-- > 1;)
+    {
+        const FeatherParams scaled = scaleDetail(_params, steps[i]);
+        const double samples = 2.0 * scaled.numBarbs * scaled.barbLOD;
+        if (samples * m_msPerSample <= m_progressive.budgetMs)
+            return i;
+    }
+    return 0;
+}
+
+void FeatherGenerator::generateStep(std::unique_lock<std::mutex> &io_lock, const FeatherParams &_params, float _detail)
+{
+    const FeatherParams scaled = scaleDetail(_params, _detail);
+    if (m_back == nullptr)
+        m_back = std::make_unique<Feather>();
+    m_back->setNumThreads(m_numThreads);
+    io_lock.unlock();
+
+    // m_back is only touched here while m_busy is set
+    m_back->setParams(scaled);
+    m_back->generate();
+    // the feather keeps its own stage times, the GL thread reads them after the swap
+    const double barbsMs = m_back->getStageTimes().allBarbsMs;
+
+    io_lock.lock();
+    if (barbsMs > 0.0)
+        m_msPerSample = barbsMs / (2.0 * scaled.numBarbs * scaled.barbLOD);
+    // an untaken result is older than this one, so it is simply reused
+    std::swap(m_back, m_ready);
+    m_hasResult = true;
+    std::function<void()> onReady = m_onReady;
+    io_lock.unlock();
+    if (onReady)
+        onReady();
+    io_lock.lock();
+}
+
+void FeatherGenerator::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_quit || m_pending; });
+        if (m_quit)
+            return;
+
+        FeatherParams params = std::move(*m_pending);
+        m_pending.reset();
+        m_busy = true;
+
+        if (!m_progressive.enabled)
+        {
+            generateStep(lock, params, 1.0f);
+        }
+        else
+        {
+            const std::vector<float> steps = m_progressive.steps;
+            std::size_t step = previewStep(params);
+            generateStep(lock, params, steps[step]);
+            // refine only once the edits have settled, a new snapshot starts over from its preview
+            if (step + 1 < steps.size() &&
+                !m_wake.wait_for(lock, m_progressive.settleTime, [this] { return m_quit || m_pending; }))
+            {
+                while (++step < steps.size() && !m_quit && !m_pending)
+                    generateStep(lock, params, steps[step]);
+            }
+        }
+
+        // idle only once the callback has run, so wait() also covers it
+        if (!m_pending)
+        {
+            m_busy = false;
+            m_idle.notify_all();
+        }
+    }
+}
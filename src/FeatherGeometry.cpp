@@ -0,0 +1,311 @@
+/// @file FeatherGeometry.cpp
+/// @brief reentrant feather generation from a FeatherParams into an Arena
+
+#include "FeatherGeometry.h"
+#include "BarbBatch.h"
+#include "BernsteinBasis.h"
+#include "Curve.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace
+{
+    /// @brief copy curve samples into the arena
+    std::span<const ngl::Vec3> copyToArena(Arena &io_arena, std::span<const ngl::Vec3> _points)
+    {
+        std::span<ngl::Vec3> copy = io_arena.allocate<ngl::Vec3>(_points.size());
+        std::copy(_points.begin(), _points.end(), copy.begin());
+        return copy;
+    }
+
+    void setCubic(BezierCurve &o_curve, const ngl::Vec3 _cp[4], unsigned int _lod) noexcept
+    {
+        o_curve.setControlPoints(std::span<const ngl::Vec3>(_cp, 4));
+        o_curve.setLOD(_lod);
+    }
+
+    /// @brief push an evenly spaced barb fraction by its jitter, 0 jitter returns it untouched
+    ngl::Real jitterFraction(const FeatherParams &_params, ngl::Real _fraction, std::size_t _i) noexcept
+    {
+        const ngl::Real jitter = std::clamp(_params.barbJitter, 0.0f, 1.0f);
+        if (jitter == 0.0f || _params.numBarbs < 2)
+        {
+            return _fraction;
+        }
+        const ngl::Real halfGap = 0.5f / static_cast<ngl::Real>(_params.numBarbs - 1);
+        return std::clamp(_fraction + jitter * halfGap * barbJitterSample(_params.seed, _i), 0.0f, 1.0f);
+    }
+} // end anonymous namespace
+
+ngl::Real barbJitterSample(std::uint32_t _seed, std::size_t _i) noexcept
+{
+    // splitmix64 of the seed and index, so every barb draws independently of the others
+    std::uint64_t z = (static_cast<std::uint64_t>(_seed) << 32 | static_cast<std::uint32_t>(_i)) +
+                      0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    // top 24 bits fill a float mantissa exactly
+    return static_cast<ngl::Real>(z >> 40) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+void barbControlPoints(const ngl::Vec3 &_p0, const ngl::Vec3 &_p3, const BarbShape &_shape, bool _isLeftSide,
+                       ngl::Vec3 o_cp[4]) noexcept
+{
+    // Calculate distance between p0 and p3
+    const ngl::Real d = (_p3 - _p0).length();
+
+    // Calculate p1 position based on factors
+    // For left side: p1.x = p0.x + v1 (where -Fb*d < v1 < 0)
+    // For right side: p1.x = p0.x + v1 (where 0 < v1 < Fb*d) - inverted
+    // p1.y = p0.y + v2 (where -Fb*d < v2 < Fb*d) - same for both sides
+    ngl::Real v1, v3;
+    if (_isLeftSide)
+    {
+        v1 = -_shape.fb * d * _shape.p1XFactor; // Maps 0-1 to (-Fb*d, 0) for left
+        v3 = _shape.fb * d * _shape.p2XFactor;  // Maps 0-1 to (0, Fb*d) for left
+    }
+    else
+    {
+        v1 = _shape.fb * d * _shape.p1XFactor;  // Maps 0-1 to (0, Fb*d) for right - inverted
+        v3 = -_shape.fb * d * _shape.p2XFactor; // Maps 0-1 to (-Fb*d, 0) for right - inverted
+    }
+
+    const ngl::Real v2 = (2.0f * _shape.p1YFactor - 1.0f) * _shape.fb * d; // Maps 0-1 to (-Fb*d, Fb*d)
+    const ngl::Real v4 = (2.0f * _shape.p2YFactor - 1.0f) * _shape.fb * d; // Maps 0-1 to (-Fb*d, Fb*d)
+
+    o_cp[0] = _p0;
+    o_cp[1] = ngl::Vec3(_p0.m_x + v1, _p0.m_y + v2, _p0.m_z);
+    o_cp[2] = ngl::Vec3(_p3.m_x + v3, _p3.m_y + v4, _p0.m_z);
+    o_cp[3] = _p3;
+}
+
+void outlineControlPoints(const FeatherParams &_params, std::span<const ngl::Vec3> _rachisSamples,
+                          ngl::Vec3 o_left[4], ngl::Vec3 o_right[4]) noexcept
+{
+    // Both outlines start on the rachis at the F0 sample
+    int startIndex = static_cast<int>(_params.f0 * (_params.sampleNum - 1));
+    if (startIndex >= static_cast<int>(_rachisSamples.size()))
+    {
+        startIndex = static_cast<int>(_rachisSamples.size()) - 1;
+    }
+    const ngl::Vec3 p0 = _rachisSamples[startIndex];
+
+    o_left[0] = p0;
+    o_left[1] = _params.outlineP1;
+    o_left[2] = _params.outlineP2;
+    o_left[3] = _params.outlineP3;
+    o_right[0] = p0;
+    if (_params.outlineSymmetric)
+    {
+        // mirror the left side in x
+        o_right[1] = ngl::Vec3(-_params.outlineP1.m_x, _params.outlineP1.m_y, _params.outlineP1.m_z);
+        o_right[2] = ngl::Vec3(-_params.outlineP2.m_x, _params.outlineP2.m_y, _params.outlineP2.m_z);
+    }
+    else
+    {
+        o_right[1] = _params.rightOutlineP1;
+        o_right[2] = _params.rightOutlineP2;
+    }
+    o_right[3] = _params.outlineP3;
+}
+
+unsigned int outlineLOD(const FeatherParams &_params) noexcept
+{
+    return static_cast<unsigned int>(_params.sampleNum * (1.0f - _params.f0));
+}
+
+void barbParameters(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                    BezierCurve &_rightOutline, std::span<ngl::Real> o_tRachis,
+                    std::span<ngl::Real> o_tLeftOutline, std::span<ngl::Real> o_tRightOutline,
+                    [[maybe_unused]] int _numThreads)
+{
+    const unsigned int numBarbs = _params.numBarbs;
+    // Barbs start at F0 position and distribute towards tip (but not all the way to 1.0)
+    const ngl::Real barbStart = _params.f0;
+    const ngl::Real barbEnd = _params.fn;
+    const ngl::Real barbRegionLength = std::clamp(barbEnd - barbStart, 0.0f, 1.0f);
+    // clamped the way Feather::setOutlineMappingRange stores it
+    const ngl::Real mappingStart = std::clamp(_params.outlineMappingStart, 0.0f, 1.0f);
+    const ngl::Real mappingEnd = std::max(std::clamp(_params.outlineMappingEnd, 0.0f, 1.0f), mappingStart);
+
+    if (_params.barbSpacing == BarbSpacing::ARC_LENGTH)
+    {
+        // Equal distances along the rachis, the arc length tables are built once
+        // per curve change so each barb is a binary search plus Newton steps
+        const ngl::Real sStart = _rachis.getLengthAtParameter(barbStart);
+        const ngl::Real sEnd = _rachis.getLengthAtParameter(barbEnd);
+        const ngl::Real leftLength = _leftOutline.getLength();
+        const ngl::Real rightLength = _rightOutline.getLength();
+        // the tables are built above, the lookups below only read them
+        #pragma omp parallel for schedule(static) num_threads(_numThreads)
+        for (int j = 0; j < static_cast<int>(numBarbs); ++j)
+        {
+            const unsigned i = static_cast<unsigned>(j);
+            const ngl::Real fraction = jitterFraction(_params, numBarbs > 1 ?
+                static_cast<ngl::Real>(i) / static_cast<ngl::Real>(numBarbs - 1) : 0.0f, i);
+            o_tRachis[i] = _rachis.getParameterAtLength(sStart + fraction * (sEnd - sStart));
+
+            // Map to the same fraction of the outline mapping range, by distance along each outline
+            const ngl::Real mapped = mappingStart + fraction * (mappingEnd - mappingStart);
+            o_tLeftOutline[i] = _leftOutline.getParameterAtLength(mapped * leftLength);
+            o_tRightOutline[i] = _rightOutline.getParameterAtLength(mapped * rightLength);
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i < numBarbs; ++i)
+    {
+        // Position along rachis, a single barb sits at F0
+        const ngl::Real fraction = jitterFraction(_params, numBarbs > 1 ?
+            static_cast<ngl::Real>(i) / static_cast<ngl::Real>(numBarbs - 1) : 0.0f, i);
+        const ngl::Real tRachis = barbStart + fraction * (barbEnd - barbStart);
+
+        // Map to outline position, an empty barb region (Fn <= F0) maps by the fraction alone
+        const ngl::Real regionFraction = barbRegionLength > 0.0f ?
+            (tRachis - barbStart) / barbRegionLength : fraction;
+        const ngl::Real tOutline = mappingStart + regionFraction * (mappingEnd - mappingStart);
+
+        o_tRachis[i] = tRachis;
+        o_tLeftOutline[i] = tOutline;
+        o_tRightOutline[i] = tOutline;
+    }
+}
+
+void buildRachis(const FeatherParams &_params, BezierCurve &o_rachis) noexcept
+{
+    const ngl::Vec3 cp[4] = {_params.rachisP0, _params.rachisP1, _params.rachisP2, _params.rachisP3};
+    setCubic(o_rachis, cp, _params.sampleNum);
+}
+
+bool buildOutlines(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &o_leftOutline,
+                   BezierCurve &o_rightOutline) noexcept
+{
+    const std::span<const ngl::Vec3> rachisSamples = _rachis.getSampleView();
+    if (rachisSamples.empty())
+    {
+        return false;
+    }
+    ngl::Vec3 leftCP[4];
+    ngl::Vec3 rightCP[4];
+    outlineControlPoints(_params, rachisSamples, leftCP, rightCP);
+    setCubic(o_leftOutline, leftCP, outlineLOD(_params));
+    setCubic(o_rightOutline, rightCP, outlineLOD(_params));
+    return true;
+}
+
+void buildTemplateBarbs(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                        BezierCurve &_rightOutline, BezierCurve &o_leftBarb, BezierCurve &o_rightBarb) noexcept
+{
+    const BarbShape shape = _params.barbShape();
+    const ngl::Vec3 root = _rachis.getPointOnCurve(_params.f0 + (1.0f - _params.f0) * 0.5f);
+    ngl::Vec3 cp[4];
+    barbControlPoints(root, _leftOutline.getPointOnCurve(_params.leftBarbOutlineFactor), shape, true, cp);
+    setCubic(o_leftBarb, cp, shape.lod);
+    barbControlPoints(root, _rightOutline.getPointOnCurve(_params.rightBarbOutlineFactor), shape, false, cp);
+    setCubic(o_rightBarb, cp, shape.lod);
+}
+
+void buildBarbs(const FeatherParams &_params, BezierCurve &_rachis, BezierCurve &_leftOutline,
+                BezierCurve &_rightOutline, const BernsteinBasis &_basis, CubicBatch &io_controlPoints,
+                const BarbTargets &o_barbs, int _numThreads)
+{
+    const std::size_t numBarbs = _params.numBarbs;
+    barbParameters(_params, _rachis, _leftOutline, _rightOutline, o_barbs.tRachis, o_barbs.tLeftOutline,
+                   o_barbs.tRightOutline, _numThreads);
+
+    // Every output goes into a preallocated slot so threads never share a write
+    // and the barb order does not depend on the thread count
+    const BarbShape shape = _params.barbShape();
+    ngl::Vec3 *samples = o_barbs.samples.data();
+    const int numChunks = static_cast<int>((numBarbs + s_barbChunkSize - 1) / s_barbChunkSize);
+
+    #pragma omp parallel for schedule(static) num_threads(_numThreads)
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+    {
+        FEATHER_TRACE_SCOPE("buildBarbs chunk");
+        const std::size_t begin = static_cast<std::size_t>(chunk) * s_barbChunkSize;
+        const std::size_t count = std::min(s_barbChunkSize, numBarbs - begin);
+        const std::size_t end = begin + count;
+
+        // Gather the barb roots and tips of this chunk in one pass per curve
+        _rachis.evaluate(o_barbs.tRachis.subspan(begin, count), o_barbs.roots.subspan(begin, count));
+        _leftOutline.evaluate(o_barbs.tLeftOutline.subspan(begin, count), o_barbs.leftTips.subspan(begin, count));
+        _rightOutline.evaluate(o_barbs.tRightOutline.subspan(begin, count), o_barbs.rightTips.subspan(begin, count));
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            ngl::Vec3 cp[4];
+            barbControlPoints(o_barbs.roots[i], o_barbs.leftTips[i], shape, true, cp);
+            io_controlPoints.set(i, cp);
+            barbControlPoints(o_barbs.roots[i], o_barbs.rightTips[i], shape, false, cp);
+            io_controlPoints.set(numBarbs + i, cp);
+        }
+
+        // Tessellate the chunk's left and right barbs straight into the samples
+        evaluateCubicBatch(io_controlPoints, _basis, begin, end, samples);
+        evaluateCubicBatch(io_controlPoints, _basis, numBarbs + begin, numBarbs + end, samples);
+    }
+}
+
+FeatherGeometry generateFeather(const FeatherParams &_params, Arena &io_arena)
+{
+    FEATHER_TRACE_SCOPE("generateFeather");
+    // Working curves of this thread, rebuilt in place by every call so only the
+    // first feather on a thread, or a larger one, allocates outside the arena
+    struct Scratch
+    {
+        BezierCurve rachis;
+        BezierCurve leftOutline;
+        BezierCurve rightOutline;
+        BezierCurve leftBarb;
+        BezierCurve rightBarb;
+        CubicBatch controlPoints;
+        BernsteinBasis basis;
+    };
+    thread_local Scratch scratch;
+
+    FeatherGeometry geometry;
+    buildRachis(_params, scratch.rachis);
+    geometry.rachis = copyToArena(io_arena, scratch.rachis.getSampleView());
+    if (!buildOutlines(_params, scratch.rachis, scratch.leftOutline, scratch.rightOutline))
+    {
+        return geometry;
+    }
+    geometry.leftOutline = copyToArena(io_arena, scratch.leftOutline.getSampleView());
+    geometry.rightOutline = copyToArena(io_arena, scratch.rightOutline.getSampleView());
+
+    buildTemplateBarbs(_params, scratch.rachis, scratch.leftOutline, scratch.rightOutline, scratch.leftBarb,
+                       scratch.rightBarb);
+    geometry.leftTemplateBarb = copyToArena(io_arena, scratch.leftBarb.getSampleView());
+    geometry.rightTemplateBarb = copyToArena(io_arena, scratch.rightBarb.getSampleView());
+
+    const std::size_t numBarbs = _params.numBarbs;
+    geometry.numBarbs = numBarbs;
+    geometry.barbLOD = _params.barbLOD;
+    if (numBarbs == 0)
+    {
+        return geometry;
+    }
+    BarbTargets barbs;
+    barbs.tRachis = io_arena.allocate<ngl::Real>(numBarbs);
+    barbs.tLeftOutline = io_arena.allocate<ngl::Real>(numBarbs);
+    barbs.tRightOutline = io_arena.allocate<ngl::Real>(numBarbs);
+    barbs.roots = io_arena.allocate<ngl::Vec3>(numBarbs);
+    barbs.leftTips = io_arena.allocate<ngl::Vec3>(numBarbs);
+    barbs.rightTips = io_arena.allocate<ngl::Vec3>(numBarbs);
+    barbs.samples = io_arena.allocate<ngl::Vec3>(2 * numBarbs * _params.barbLOD);
+    scratch.controlPoints.resize(2 * numBarbs);
+    if (!scratch.basis.matches(3, _params.barbLOD))
+    {
+        scratch.basis.rebuild(3, _params.barbLOD);
+    }
+    buildBarbs(_params, scratch.rachis, scratch.leftOutline, scratch.rightOutline, scratch.basis,
+               scratch.controlPoints, barbs);
+
+    geometry.barbRoots = barbs.roots;
+    geometry.leftBarbTips = barbs.leftTips;
+    geometry.rightBarbTips = barbs.rightTips;
+    geometry.barbSamples = barbs.samples;
+    return geometry;
+}
@@ -0,0 +1,388 @@
+/// @file FeatherIO.cpp
+/// @brief text parameter files and OBJ output for batch feather generation
+
+#include "FeatherIO.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+
+namespace
+{
+    bool parseValue(std::istream &_in, ngl::Real &o_value)
+    {
+        return static_cast<bool>(_in >> o_value);
+    }
+
+    bool parseValue(std::istream &_in, unsigned int &o_value)
+    {
+        // operator>> accepts "-1" for unsigned types and wraps it
+        _in >> std::ws;
+        if (_in.peek() == '-')
+        {
+            return false;
+        }
+        return static_cast<bool>(_in >> o_value);
+    }
+
+    bool parseValue(std::istream &_in, ngl::Vec3 &o_value)
+    {
+        return static_cast<bool>(_in >> o_value.m_x >> o_value.m_y >> o_value.m_z);
+    }
+
+    bool parseValue(std::istream &_in, bool &o_value)
+    {
+        std::string word;
+        _in >> word;
+        if (word == "true" || word == "1")
+        {
+            o_value = true;
+            return true;
+        }
+        if (word == "false" || word == "0")
+        {
+            o_value = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseValue(std::istream &_in, BarbSpacing &o_value)
+    {
+        std::string word;
+        _in >> word;
+        if (word == "parametric")
+        {
+            o_value = BarbSpacing::PARAMETRIC;
+            return true;
+        }
+        if (word == "arc_length")
+        {
+            o_value = BarbSpacing::ARC_LENGTH;
+            return true;
+        }
+        return false;
+    }
+
+    void printValue(std::ostream &_out, ngl::Real _value) { _out << _value; }
+    void printValue(std::ostream &_out, unsigned int _value) { _out << _value; }
+    void printValue(std::ostream &_out, bool _value) { _out << (_value ? "true" : "false"); }
+    void printValue(std::ostream &_out, const ngl::Vec3 &_value)
+    {
+        _out << _value.m_x << ' ' << _value.m_y << ' ' << _value.m_z;
+    }
+    void printValue(std::ostream &_out, BarbSpacing _value)
+    {
+        _out << (_value == BarbSpacing::ARC_LENGTH ? "arc_length" : "parametric");
+    }
+
+    template <auto Member>
+    bool readField(std::istream &_in, FeatherParams &o_params)
+    {
+        // parse into a copy so a malformed value leaves the field as it was,
+        // the whole value has to be consumed, "3 4" is not a number
+        auto value = o_params.*Member;
+        if (!parseValue(_in, value) || !(_in >> std::ws).eof())
+        {
+            return false;
+        }
+        o_params.*Member = value;
+        return true;
+    }
+
+    template <auto Member>
+    void writeField(std::ostream &_out, const FeatherParams &_params)
+    {
+        printValue(_out, _params.*Member);
+    }
+
+    /// @brief one key of the parameter file
+    struct Field
+    {
+        std::string_view key;
+        bool (*read)(std::istream &, FeatherParams &);
+        void (*write)(std::ostream &, const FeatherParams &);
+    };
+
+#define FEATHER_FIELD(name) Field{#name, &readField<&FeatherParams::name>, &writeField<&FeatherParams::name>}
+    /// @brief every field in FeatherParams order
+    constexpr Field s_fields[] = {
+        FEATHER_FIELD(rachisP0),
+        FEATHER_FIELD(rachisP1),
+        FEATHER_FIELD(rachisP2),
+        FEATHER_FIELD(rachisP3),
+        FEATHER_FIELD(sampleNum),
+        FEATHER_FIELD(outlineSymmetric),
+        FEATHER_FIELD(outlineP1),
+        FEATHER_FIELD(outlineP2),
+        FEATHER_FIELD(outlineP3),
+        FEATHER_FIELD(rightOutlineP1),
+        FEATHER_FIELD(rightOutlineP2),
+        FEATHER_FIELD(f0),
+        FEATHER_FIELD(fn),
+        FEATHER_FIELD(numBarbs),
+        FEATHER_FIELD(barbLOD),
+        FEATHER_FIELD(barbSpacing),
+        FEATHER_FIELD(outlineMappingStart),
+        FEATHER_FIELD(outlineMappingEnd),
+        FEATHER_FIELD(fb),
+        FEATHER_FIELD(p1XFactor),
+        FEATHER_FIELD(p1YFactor),
+        FEATHER_FIELD(p2XFactor),
+        FEATHER_FIELD(p2YFactor),
+        FEATHER_FIELD(leftBarbOutlineFactor),
+        FEATHER_FIELD(rightBarbOutlineFactor),
+        FEATHER_FIELD(barbJitter),
+        FEATHER_FIELD(seed),
+        FEATHER_FIELD(showOutlines),
+    };
+#undef FEATHER_FIELD
+
+    /// @brief the first value outside the range of the MainWindow control that sets it
+    struct Violation
+    {
+        std::string_view key;
+        std::string message;
+    };
+
+    /// @brief upper limit of the sample, barb and barb LOD spin boxes
+    constexpr unsigned int s_maxCount = 10000;
+
+    bool findViolation(const FeatherParams &_params, Violation &o_violation)
+    {
+        const std::pair<std::string_view, unsigned int> counts[] = {
+            {"sampleNum", _params.sampleNum},
+            {"numBarbs", _params.numBarbs},
+            {"barbLOD", _params.barbLOD},
+        };
+        for (const auto &[key, value] : counts)
+        {
+            if (value > s_maxCount)
+            {
+                o_violation = {key, "must be at most " + std::to_string(s_maxCount) + ", got " + std::to_string(value)};
+                return true;
+            }
+        }
+
+        // the barb end factors start at 0.4 in the UI, below that the tips leave the outline
+        struct Range
+        {
+            std::string_view key;
+            ngl::Real value;
+            ngl::Real min;
+        };
+        const Range factors[] = {
+            {"f0", _params.f0, 0.0f},
+            {"fn", _params.fn, 0.0f},
+            {"outlineMappingStart", _params.outlineMappingStart, 0.0f},
+            {"outlineMappingEnd", _params.outlineMappingEnd, 0.0f},
+            {"fb", _params.fb, 0.0f},
+            {"p1XFactor", _params.p1XFactor, 0.0f},
+            {"p1YFactor", _params.p1YFactor, 0.0f},
+            {"p2XFactor", _params.p2XFactor, 0.0f},
+            {"p2YFactor", _params.p2YFactor, 0.0f},
+            {"leftBarbOutlineFactor", _params.leftBarbOutlineFactor, 0.4f},
+            {"rightBarbOutlineFactor", _params.rightBarbOutlineFactor, 0.4f},
+            {"barbJitter", _params.barbJitter, 0.0f},
+        };
+        for (const Range &factor : factors)
+        {
+            // written so NaN fails as well
+            if (!(factor.value >= factor.min && factor.value <= 1.0f))
+            {
+                std::ostringstream message;
+                message << "must be between " << factor.min << " and 1, got " << factor.value;
+                o_violation = {factor.key, message.str()};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t fieldIndex(std::string_view _key) noexcept
+    {
+        return static_cast<std::size_t>(std::find_if(std::begin(s_fields), std::end(s_fields),
+                                                      [_key](const Field &_field) { return _field.key == _key; }) -
+                                         std::begin(s_fields));
+    }
+
+    std::string_view trim(std::string_view _text) noexcept
+    {
+        const auto first = _text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+        {
+            return {};
+        }
+        const auto last = _text.find_last_not_of(" \t\r");
+        return _text.substr(first, last - first + 1);
+    }
+
+    /// @brief append a float in its shortest round trip form
+    void appendReal(std::string &io_text, ngl::Real _value)
+    {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), _value);
+        io_text.append(buffer, result.ptr);
+    }
+
+    void appendIndex(std::string &io_text, std::size_t _index)
+    {
+        char buffer[24];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), _index);
+        io_text.append(buffer, result.ptr);
+    }
+
+    /// @brief OBJ writer state, vertex indices run on across objects
+    struct ObjWriter
+    {
+        std::ostream &out;
+        std::string text;
+        std::size_t numVertices = 0;
+
+        /// @brief write _points as an object of polylines of _stride points each
+        void object(std::string_view _name, std::span<const ngl::Vec3> _points, std::size_t _stride)
+        {
+            if (_points.empty() || _stride < 2)
+            {
+                return;
+            }
+            text.clear();
+            text.append("o ").append(_name).append("\n");
+            for (const ngl::Vec3 &p : _points)
+            {
+                text.append("v ");
+                appendReal(text, p.m_x);
+                text.push_back(' ');
+                appendReal(text, p.m_y);
+                text.push_back(' ');
+                appendReal(text, p.m_z);
+                text.push_back('\n');
+            }
+            for (std::size_t first = 0; first + _stride <= _points.size(); first += _stride)
+            {
+                text.push_back('l');
+                for (std::size_t i = 0; i < _stride; ++i)
+                {
+                    text.push_back(' ');
+                    // OBJ indices start at 1
+                    appendIndex(text, numVertices + first + i + 1);
+                }
+                text.push_back('\n');
+            }
+            numVertices += _points.size();
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+    };
+} // end anonymous namespace
+
+bool readFeatherParams(std::istream &_in, FeatherParams &o_params, std::string &o_error)
+{
+    // where each key was last set, 0 for keys the file leaves at their value
+    std::array<int, std::size(s_fields)> keyLines{};
+    std::string line;
+    for (int lineNumber = 1; std::getline(_in, line); ++lineNumber)
+    {
+        std::string_view text = line;
+        text = trim(text.substr(0, text.find('#')));
+        if (text.empty())
+        {
+            continue;
+        }
+        const auto equals = text.find('=');
+        if (equals == std::string_view::npos)
+        {
+            o_error = "line " + std::to_string(lineNumber) + ": expected key = value";
+            return false;
+        }
+        const std::string_view key = trim(text.substr(0, equals));
+        const auto field = std::find_if(std::begin(s_fields), std::end(s_fields),
+                                        [key](const Field &_field) { return _field.key == key; });
+        if (field == std::end(s_fields))
+        {
+            o_error = "line " + std::to_string(lineNumber) + ": unknown key '" + std::string(key) + "'";
+            return false;
+        }
+        std::string value(trim(text.substr(equals + 1)));
+        std::replace(value.begin(), value.end(), ',', ' ');
+        std::istringstream valueStream(value);
+        if (!field->read(valueStream, o_params))
+        {
+            o_error = "line " + std::to_string(lineNumber) + ": bad value '" + value + "' for " + std::string(key);
+            return false;
+        }
+        keyLines[static_cast<std::size_t>(field - std::begin(s_fields))] = lineNumber;
+    }
+
+    Violation violation;
+    if (findViolation(o_params, violation))
+    {
+        const int lineNumber = keyLines[fieldIndex(violation.key)];
+        o_error = (lineNumber > 0 ? "line " + std::to_string(lineNumber) + ": " : std::string()) +
+                  std::string(violation.key) + " " + violation.message;
+        return false;
+    }
+    return true;
+}
+
+bool validateFeatherParams(const FeatherParams &_params, std::string &o_error)
+{
+    Violation violation;
+    if (findViolation(_params, violation))
+    {
+        o_error = std::string(violation.key) + " " + violation.message;
+        return false;
+    }
+    return true;
+}
+
+bool loadFeatherParams(const std::filesystem::path &_path, FeatherParams &o_params, std::string &o_error)
+{
+    std::ifstream file(_path);
+    if (!file)
+    {
+        o_error = "cannot open " + _path.string();
+        return false;
+    }
+    return readFeatherParams(file, o_params, o_error);
+}
+
+void writeFeatherParams(std::ostream &_out, const FeatherParams &_params)
+{
+    const auto flags = _out.flags();
+    const auto precision = _out.precision(std::numeric_limits<ngl::Real>::max_digits10);
+    for (const Field &field : s_fields)
+    {
+        _out << field.key << " = ";
+        field.write(_out, _params);
+        _out << '\n';
+    }
+    _out.precision(precision);
+    _out.flags(flags);
+}
+
+std::size_t writeFeatherObj(std::ostream &_out, const FeatherGeometry &_geometry, bool _outlines)
+{
+    ObjWriter writer{_out, {}};
+    writer.text.reserve(64 * 1024);
+    writer.object("rachis", _geometry.rachis, _geometry.rachis.size());
+    if (_outlines)
+    {
+        writer.object("leftOutline", _geometry.leftOutline, _geometry.leftOutline.size());
+        writer.object("rightOutline", _geometry.rightOutline, _geometry.rightOutline.size());
+        writer.object("leftTemplateBarb", _geometry.leftTemplateBarb, _geometry.leftTemplateBarb.size());
+        writer.object("rightTemplateBarb", _geometry.rightTemplateBarb, _geometry.rightTemplateBarb.size());
+    }
+    const std::size_t sideSamples = _geometry.numBarbs * _geometry.barbLOD;
+    if (sideSamples != 0)
+    {
+        writer.object("leftBarbs", _geometry.barbSamples.first(sideSamples), _geometry.barbLOD);
+        writer.object("rightBarbs", _geometry.barbSamples.subspan(sideSamples, sideSamples), _geometry.barbLOD);
+    }
+    return writer.numVertices;
+}
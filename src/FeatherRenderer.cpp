@@ -0,0 +1,142 @@
+/// @file FeatherRenderer.cpp
+/// @brief GL resources and draw calls for the geometry of a Feather
+
+#include "FeatherRenderer.h"
+#include "Feather.h"
+#include "VertexUpload.h"
+#include "Trace.h"
+#include "ngl/VAOFactory.h"
+#include "ngl/SimpleVAO.h"
+
+namespace
+{
+void uploadCurve(CurveVAO &_vao, BezierCurve *_curve)
+{
+    if (_curve != nullptr)
+        _vao.upload(*_curve);
+    else
+        _vao.upload({}, {});
+}
+} // end anonymous namespace
+
+void FeatherRenderer::upload(const Feather &_feather, unsigned int _stages)
+{
+    FEATHER_TRACE_SCOPE("FeatherRenderer::upload");
+    m_showOutlines = _feather.getShowOutlines();
+    if (m_barbRenderModeChanged)
+    {
+        _stages |= static_cast<unsigned int>(FeatherStage::ALL_BARBS);
+        m_barbRenderModeChanged = false;
+    }
+
+    if (_stages & static_cast<unsigned int>(FeatherStage::RACHIS))
+    {
+        uploadCurve(m_rachis, _feather.getRachis());
+    }
+
+    if (_stages & static_cast<unsigned int>(FeatherStage::OUTLINES))
+    {
+        uploadCurve(m_leftOutline, _feather.getOutline(BarbSide::LEFT));
+        uploadCurve(m_rightOutline, _feather.getOutline(BarbSide::RIGHT));
+    }
+
+    if (_stages & static_cast<unsigned int>(FeatherStage::TEMPLATE_BARBS))
+    {
+        uploadCurve(m_leftBarb, _feather.getTemplateBarb(BarbSide::LEFT));
+        uploadCurve(m_rightBarb, _feather.getTemplateBarb(BarbSide::RIGHT));
+    }
+
+    if (_stages & static_cast<unsigned int>(FeatherStage::ALL_BARBS))
+    {
+        uploadBarbs(_feather);
+    }
+}
+
+void FeatherRenderer::uploadBarbs(const Feather &_feather)
+{
+    if (m_barbRenderMode == BarbRenderMode::INSTANCED && !m_instancedBarbs.init())
+    {
+        m_barbRenderMode = BarbRenderMode::TESSELLATED;
+    }
+
+    if (m_barbRenderMode == BarbRenderMode::INSTANCED)
+    {
+        // 24 bytes per barb, the shape factors are uniforms
+        m_instancedBarbs.setShape(_feather.getBarbShape());
+        m_instancedBarbs.setInstances(_feather.getBarbRoots(), _feather.getBarbTips(BarbSide::LEFT),
+                                      _feather.getBarbTips(BarbSide::RIGHT));
+        return;
+    }
+
+    const BarbBuffer &barbs = _feather.getBarbs();
+    if (m_barbVAO == nullptr)
+    {
+        m_barbVAO = ngl::VAOFactory::createVAO("simpleVAO", GL_LINE_STRIP);
+        m_barbCapacity = 0;
+    }
+    m_barbVAO->bind();
+    auto samples = barbs.samples();
+    streamPoints(*m_barbVAO, m_barbCapacity, samples.data(), samples.size());
+    m_barbVAO->unbind();
+    // copied so drawing never touches the feather again
+    m_barbFirsts.assign(barbs.drawFirsts().begin(), barbs.drawFirsts().end());
+    m_barbCounts.assign(barbs.drawCounts().begin(), barbs.drawCounts().end());
+    m_barbVertices = samples.size();
+}
+
+void FeatherRenderer::setBarbRenderMode(BarbRenderMode _mode) noexcept
+{
+    if (m_barbRenderMode != _mode)
+    {
+        m_barbRenderMode = _mode;
+        m_barbRenderModeChanged = true;
+    }
+}
+
+void FeatherRenderer::drawRachis() const
+{
+    m_rachis.draw();
+}
+
+void FeatherRenderer::drawOutlines() const
+{
+    m_leftOutline.draw();
+    m_rightOutline.draw();
+}
+
+void FeatherRenderer::drawBarb() const
+{
+    if (!m_leftBarb.empty() && !m_rightBarb.empty())
+    {
+        m_leftBarb.drawControlPoints();
+        m_leftBarb.draw();
+        m_rightBarb.drawControlPoints();
+        m_rightBarb.draw();
+    }
+}
+
+void FeatherRenderer::drawAllBarbs() const
+{
+    if (m_barbRenderMode == BarbRenderMode::INSTANCED)
+    {
+        m_instancedBarbs.draw(m_mvp);
+        return;
+    }
+    if (m_barbVAO == nullptr || m_barbFirsts.empty())
+        return;
+    // every barb is its own strip inside the one buffer
+    m_barbVAO->bind();
+    glMultiDrawArrays(GL_LINE_STRIP, m_barbFirsts.data(), m_barbCounts.data(), static_cast<GLsizei>(m_barbFirsts.size()));
+    m_barbVAO->unbind();
+    recordDraw(m_barbVertices);
+}
+
+void FeatherRenderer::draw() const
+{
+    drawRachis();
+    if (m_showOutlines)
+    {
+        drawOutlines();
+    }
+    drawAllBarbs();
+}
@@ -0,0 +1,87 @@
+/// @file FrameStats.cpp
+/// @brief rolling averages of where frame and generation time goes, shown by the NGLScene overlay
+
+#include "FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+
+RollingAverage::RollingAverage(std::size_t _window) : m_values(std::max<std::size_t>(_window, 1), 0.0)
+{
+}
+
+void RollingAverage::add(double _value) noexcept
+{
+    if (m_count == m_values.size())
+        m_sum -= m_values[m_next];
+    else
+        ++m_count;
+    m_values[m_next] = _value;
+    m_sum += _value;
+    m_next = (m_next + 1) % m_values.size();
+    // resum once per lap so rounding from the subtractions cannot build up
+    if (m_next == 0)
+    {
+        m_sum = 0.0;
+        for (double value : m_values)
+            m_sum += value;
+    }
+}
+
+FrameStats::FrameStats(std::size_t _window)
+    : m_rachisMs(_window), m_outlinesMs(_window), m_templateBarbsMs(_window), m_allBarbsMs(_window),
+      m_uploadBytes(_window), m_uploadMs(_window), m_drawCalls(_window), m_vertices(_window), m_gpuMs(_window),
+      m_overlayMs(_window)
+{
+}
+
+void FrameStats::addGeneration(const FeatherStageTimes &_times) noexcept
+{
+    m_rachisMs.add(_times.rachisMs);
+    m_outlinesMs.add(_times.outlinesMs);
+    m_templateBarbsMs.add(_times.templateBarbsMs);
+    m_allBarbsMs.add(_times.allBarbsMs);
+}
+
+void FrameStats::addFrame(std::size_t _uploadBytes, double _uploadMs, std::size_t _drawCalls,
+                          std::size_t _vertices) noexcept
+{
+    m_uploadBytes.add(static_cast<double>(_uploadBytes));
+    m_uploadMs.add(_uploadMs);
+    m_drawCalls.add(static_cast<double>(_drawCalls));
+    m_vertices.add(static_cast<double>(_vertices));
+}
+
+double FrameStats::stageMs(FeatherStage _stage) const noexcept
+{
+    switch (_stage)
+    {
+    case FeatherStage::RACHIS:
+        return m_rachisMs.value();
+    case FeatherStage::OUTLINES:
+        return m_outlinesMs.value();
+    case FeatherStage::TEMPLATE_BARBS:
+        return m_templateBarbsMs.value();
+    case FeatherStage::ALL_BARBS:
+        return m_allBarbsMs.value();
+    }
+    return 0.0;
+}
+
+std::vector<std::string> FrameStats::lines() const
+{
+    std::vector<std::string> lines;
+    char line[64];
+    auto add = [&lines, &line](int _length) {
+        if (_length > 0)
+            lines.emplace_back(line, std::min<std::size_t>(static_cast<std::size_t>(_length), sizeof(line) - 1));
+    };
+    add(std::snprintf(line, sizeof(line), "rachis         %8.3f ms", m_rachisMs.value()));
+    add(std::snprintf(line, sizeof(line), "outlines       %8.3f ms", m_outlinesMs.value()));
+    add(std::snprintf(line, sizeof(line), "template barbs %8.3f ms", m_templateBarbsMs.value()));
+    add(std::snprintf(line, sizeof(line), "all barbs      %8.3f ms", m_allBarbsMs.value()));
+    add(std::snprintf(line, sizeof(line), "upload   %8.1f KB %6.3f ms", m_uploadBytes.value() / 1024.0, m_uploadMs.value()));
+    add(std::snprintf(line, sizeof(line), "draws    %8.1f  verts %8.0f", m_drawCalls.value(), m_vertices.value()));
+    add(std::snprintf(line, sizeof(line), "gpu            %8.3f ms", m_gpuMs.value()));
+    add(std::snprintf(line, sizeof(line), "overlay        %8.3f ms", m_overlayMs.value()));
+    return lines;
+}
@@ -0,0 +1,48 @@
+/// @file GpuTimer.cpp
+/// @brief GL_TIME_ELAPSED queries read back without stalling the pipeline
+
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer()
+{
+    if (m_queries[0] != 0)
+        glDeleteQueries(static_cast<GLsizei>(s_numQueries), m_queries);
+}
+
+void GpuTimer::begin()
+{
+    if (m_queries[0] == 0)
+        glGenQueries(static_cast<GLsizei>(s_numQueries), m_queries);
+    // every query still in flight, skip this frame rather than wait
+    m_active = m_issued - m_read < s_numQueries;
+    if (m_active)
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_issued % s_numQueries]);
+}
+
+void GpuTimer::end()
+{
+    if (!m_active)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    ++m_issued;
+    m_active = false;
+}
+
+bool GpuTimer::poll(double &o_ms)
+{
+    bool found = false;
+    while (m_read < m_issued)
+    {
+        const GLuint query = m_queries[m_read % s_numQueries];
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != GL_TRUE)
+            break;
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        o_ms = static_cast<double>(nanoseconds) * 1e-6;
+        ++m_read;
+        found = true;
+    }
+    return found;
+}
@@ -0,0 +1,221 @@
+/// @file InstancedBarbs.cpp
+/// @brief draws every barb as an instance of one cubic evaluated in the vertex shader
+
+#include "InstancedBarbs.h"
+#include "VertexUpload.h"
+#include <iostream>
+#include <string>
+
+namespace
+{
+// Same maths as Feather::computeBarbControlPoints, side is -1 for left barbs
+// and +1 for right barbs so it flips the x offsets of p1 and p2
+constexpr const char *s_vertexShader = R"(#version 410 core
+layout(location = 0) in vec3 inP0;
+layout(location = 1) in vec3 inP3;
+uniform mat4 MVP;
+uniform int numBarbs;
+uniform int lod;
+uniform float fb;
+uniform vec4 factors;
+out vec3 position;
+void main()
+{
+    float side = gl_InstanceID < numBarbs ? -1.0 : 1.0;
+    float fd = fb * length(inP3 - inP0);
+    vec3 p1 = vec3(inP0.x + side * fd * factors.x, inP0.y + (2.0 * factors.y - 1.0) * fd, inP0.z);
+    vec3 p2 = vec3(inP3.x - side * fd * factors.z, inP3.y + (2.0 * factors.w - 1.0) * fd, inP0.z);
+    float t = float(gl_VertexID) / float(lod);
+    float mt = 1.0 - t;
+    position = mt * mt * mt * inP0 + 3.0 * mt * mt * t * p1 + 3.0 * mt * t * t * p2 + t * t * t * inP3;
+    gl_Position = MVP * vec4(position, 1.0);
+}
+)";
+
+constexpr const char *s_fragmentShader = R"(#version 410 core
+uniform vec4 Colour;
+layout(location = 0) out vec4 fragColour;
+void main()
+{
+    fragColour = Colour;
+}
+)";
+
+GLuint compileShader(GLenum _type, const char *_source)
+{
+    GLuint shader = glCreateShader(_type);
+    glShaderSource(shader, 1, &_source, nullptr);
+    glCompileShader(shader);
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "InstancedBarbs shader failed to compile\n" << log << '\n';
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+} // end anonymous namespace
+
+InstancedBarbs::~InstancedBarbs()
+{
+    if (m_program != 0)
+    {
+        glDeleteBuffers(1, &m_instanceBuffer);
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteProgram(m_program);
+    }
+}
+
+bool InstancedBarbs::init()
+{
+    if (m_program != 0)
+        return true;
+
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, s_vertexShader);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, s_fragmentShader);
+    if (vertex == 0 || fragment == 0)
+    {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    // captured by capture(), has to be declared before linking
+    const GLchar *varyings[] = {"position"};
+    glTransformFeedbackVaryings(program, 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "InstancedBarbs shader failed to link\n" << log << '\n';
+        glDeleteProgram(program);
+        return false;
+    }
+    m_program = program;
+
+    // p0 and p3 advance once per instance, the vertex id walks the samples
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(ngl::Vec3), nullptr);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(ngl::Vec3),
+                          reinterpret_cast<const void *>(sizeof(ngl::Vec3)));
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+
+    glUseProgram(m_program);
+    glUniform4f(glGetUniformLocation(m_program, "Colour"), 1.0f, 1.0f, 1.0f, 1.0f);
+    glUseProgram(0);
+    return true;
+}
+
+void InstancedBarbs::setInstances(std::span<const ngl::Vec3> _roots, std::span<const ngl::Vec3> _leftTips,
+                                  std::span<const ngl::Vec3> _rightTips)
+{
+    m_numBarbs = _roots.size();
+    m_staging.resize(4 * m_numBarbs);
+    for (std::size_t i = 0; i < m_numBarbs; ++i)
+    {
+        m_staging[2 * i] = _roots[i];
+        m_staging[2 * i + 1] = _leftTips[i];
+        m_staging[2 * (m_numBarbs + i)] = _roots[i];
+        m_staging[2 * (m_numBarbs + i) + 1] = _rightTips[i];
+    }
+    if (m_program == 0 || m_staging.empty())
+        return;
+
+    const std::size_t bytes = m_staging.size() * sizeof(ngl::Vec3);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (bytes > m_instanceCapacity)
+    {
+        glBufferData(GL_ARRAY_BUFFER, bytes, &m_staging[0].m_x, GL_DYNAMIC_DRAW);
+        m_instanceCapacity = bytes;
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &m_staging[0].m_x);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    recordUpload(bytes);
+}
+
+void InstancedBarbs::setShape(const BarbShape &_shape) noexcept
+{
+    m_shape = _shape;
+}
+
+void InstancedBarbs::loadUniforms() const noexcept
+{
+    glUniform1i(glGetUniformLocation(m_program, "numBarbs"), static_cast<GLint>(m_numBarbs));
+    glUniform1i(glGetUniformLocation(m_program, "lod"), static_cast<GLint>(m_shape.lod));
+    glUniform1f(glGetUniformLocation(m_program, "fb"), m_shape.fb);
+    glUniform4f(glGetUniformLocation(m_program, "factors"), m_shape.p1XFactor, m_shape.p1YFactor,
+                m_shape.p2XFactor, m_shape.p2YFactor);
+}
+
+void InstancedBarbs::draw(const ngl::Mat4 &_mvp) const noexcept
+{
+    if (m_program == 0 || m_numBarbs == 0 || m_shape.lod == 0)
+        return;
+
+    GLint previousProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glUseProgram(m_program);
+    glUniformMatrix4fv(glGetUniformLocation(m_program, "MVP"), 1, GL_FALSE, &_mvp.m_m[0][0]);
+    loadUniforms();
+    glBindVertexArray(m_vao);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, static_cast<GLsizei>(m_shape.lod), static_cast<GLsizei>(2 * m_numBarbs));
+    glBindVertexArray(0);
+    recordDraw(2 * m_numBarbs * m_shape.lod);
+    // the rest of the feather is drawn with the shader that was bound before
+    glUseProgram(static_cast<GLuint>(previousProgram));
+}
+
+void InstancedBarbs::capture(std::vector<ngl::Vec3> &o_points) const
+{
+    o_points.clear();
+    if (m_program == 0 || m_numBarbs == 0 || m_shape.lod == 0)
+        return;
+
+    const std::size_t count = 2 * m_numBarbs * m_shape.lod;
+    GLuint feedback = 0;
+    glGenBuffers(1, &feedback);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, count * sizeof(ngl::Vec3), nullptr, GL_STATIC_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+
+    glUseProgram(m_program);
+    const ngl::Mat4 identity;
+    glUniformMatrix4fv(glGetUniformLocation(m_program, "MVP"), 1, GL_FALSE, &identity.m_m[0][0]);
+    loadUniforms();
+    glBindVertexArray(m_vao);
+    // instances are captured in order, so barb b lands at [b * lod, (b + 1) * lod)
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArraysInstanced(GL_POINTS, 0, static_cast<GLsizei>(m_shape.lod), static_cast<GLsizei>(2 * m_numBarbs));
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    o_points.resize(count);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, count * sizeof(ngl::Vec3), &o_points[0].m_x);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDeleteBuffers(1, &feedback);
+}
@@ -1,4 +1,5 @@
 #include <QMouseEvent>
+#include <QKeyEvent>
 #include <QGuiApplication>
 #include <iostream>
 #include "NGLScene.h"
@@ -7,14 +8,36 @@
 #include <ngl/ShaderLib.h>
 #include <iostream>
 #include "Feather.h"
+#include "VertexUpload.h"
+#include <chrono>
+#include <filesystem>
+
+namespace
+{
+/// @brief font of the timing overlay, found by CMake, empty when there is none
+#ifdef FEATHER_STATS_FONT
+constexpr const char *s_statsFont = FEATHER_STATS_FONT;
+#else
+constexpr const char *s_statsFont = "";
+#endif
+
+double millisecondsSince(std::chrono::steady_clock::time_point _start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+}
+} // end anonymous namespace
 
 NGLScene::NGLScene(QWidget *parent)
   : QOpenGLWidget(parent)
 {
+  // needed to receive the overlay key
+  setFocusPolicy(Qt::StrongFocus);
 }
 
 NGLScene::~NGLScene()
 {
+  // a result finishing during shutdown must not queue a repaint
+  m_generator.setOnReady(nullptr);
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
 }
 
@@ -23,6 +46,10 @@ void NGLScene::resizeGL(int _w, int _h)
   m_project = ngl::perspective(45.0f, static_cast<float>(_w) / _h, 0.01f, 1000.0f);
   m_win.width = static_cast<int>(_w * devicePixelRatio());
   m_win.height = static_cast<int>(_h * devicePixelRatio());
+  if (m_statsText)
+  {
+    m_statsText->setScreenSize(_w, _h);
+  }
 }
 
 void NGLScene::initializeGL()
@@ -50,8 +77,14 @@ void NGLScene::initializeGL()
   ngl::ShaderLib::use(ngl::nglColourShader);
   ngl::ShaderLib::setUniform("Colour", 1.0f, 1.0f, 1.0f, 1.0f);
 
-  // Create the feather object
-  m_feather = std::make_unique<Feather>();
+  // the worker only asks for a repaint, the swap and upload happen in paintGL
+  m_generator.setOnReady([this]() { QMetaObject::invokeMethod(this, [this]() { update(); }, Qt::QueuedConnection); });
+  // edits are previewed at reduced detail and refined once they settle
+  ProgressiveSettings progressive;
+  progressive.enabled = true;
+  m_generator.setProgressive(progressive);
+  // generate the default feather
+  m_generator.post(FeatherParams());
 }
 
 void NGLScene::loadMatricesToShader()
@@ -60,6 +93,8 @@ void NGLScene::loadMatricesToShader()
   ngl::Mat4 MVP;
   MVP = m_project * m_view * m_mouseGlobalTX;
   ngl::ShaderLib::setUniform("MVP", MVP);
+  // the instanced barb path draws with its own shader
+  m_renderer.setMVP(MVP);
 }
 
 void NGLScene::paintGL()
@@ -81,36 +116,114 @@ void NGLScene::paintGL()
   ngl::ShaderLib::use("nglColourShader");
   ngl::ShaderLib::setUniform("Colour", 1.0f, 1.0f, 1.0f, 1.0f);
 
-  /*
-  auto cps = m_feather->getRachisControlPoints();
-  std::cout << cps.size() << "\n";
-  for(auto & cp : cps)
+  unsigned int stages = 0;
+  if (m_generator.takeResult(m_feather))
   {
-    std::cout << "(" << cp.m_x << "," << cp.m_y << "," << cp.m_z << ")"<< "\n";
+    // the front feather may have skipped several snapshots, so compare against what was uploaded
+    stages = m_hasUpload ? Feather::changedStages(m_uploadedParams, m_feather->getParams()) : 0xFu;
+    m_uploadedParams = m_feather->getParams();
+    m_hasUpload = true;
+    m_frameStats.addGeneration(m_feather->getStageTimes());
   }
-  */
-
-  m_feather->update();
+  const auto uploadStart = std::chrono::steady_clock::now();
+  if (m_feather)
+  {
+    m_renderer.upload(*m_feather, stages);
+  }
+  const double uploadMs = millisecondsSince(uploadStart);
+  m_gpuTimer.begin();
   // Draw based on current mode
   switch (m_drawMode)
   {
     case DrawMode::RACHIS:
-      m_feather->drawRachis();
+      m_renderer.drawRachis();
       break;
     case DrawMode::OUTLINES:
-      m_feather->drawRachis();
-      m_feather->drawOutlines();
+      m_renderer.drawRachis();
+      m_renderer.drawOutlines();
       break;
     case DrawMode::BARB:
-      m_feather->drawRachis();
-      m_feather->drawOutlines();
-      m_feather->drawBarb();
+      m_renderer.drawRachis();
+      m_renderer.drawOutlines();
+      m_renderer.drawBarb();
       break;
     case DrawMode::ALL_COMPONENTS:
-      m_feather->draw();
+      m_renderer.draw();
       break;
   }
+  m_gpuTimer.end();
+  // idle frames (camera moves only) should report 0 here
+  m_frameUploadBytes = takeUploadedBytes();
+  const DrawCounts draws = takeDrawCounts();
+  m_frameStats.addFrame(m_frameUploadBytes, uploadMs, draws.calls, draws.vertices);
+  double gpuMs = 0.0;
+  if (m_gpuTimer.poll(gpuMs))
+  {
+    m_frameStats.addGpuTime(gpuMs);
+  }
+  if (m_showStats)
+  {
+    drawStats();
+  }
+
+}
 
+void NGLScene::drawStats()
+{
+  const auto start = std::chrono::steady_clock::now();
+  if (m_statsFrame++ % s_statsRefreshFrames == 0)
+  {
+    m_statsLines = m_frameStats.lines();
+  }
+  float y = 20.0f;
+  for (const auto &line : m_statsLines)
+  {
+    m_statsText->renderText(10.0f, y, line);
+    y += 18.0f;
+  }
+  m_frameStats.addOverlayTime(millisecondsSince(start));
+}
+
+bool NGLScene::loadStatsFont()
+{
+  if (m_statsText)
+  {
+    return true;
+  }
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(s_statsFont, error))
+  {
+    m_statsUnavailable = true;
+    std::cerr << "Timing overlay disabled, no font found"
+              << (*s_statsFont != '\0' ? std::string(" at ") + s_statsFont : std::string())
+              << ", set FEATHER_STATS_FONT when configuring\n";
+    return false;
+  }
+  m_statsText = std::make_unique<ngl::Text>(s_statsFont, 14);
+  m_statsText->setScreenSize(width(), height());
+  m_statsText->setColour(1.0f, 1.0f, 0.0f);
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void NGLScene::keyPressEvent(QKeyEvent *_event)
+{
+  if (_event->key() == Qt::Key_T)
+  {
+    // ngl::Text builds GL textures, key events arrive without the context current
+    makeCurrent();
+    if (!m_statsUnavailable && (m_showStats || loadStatsFont()))
+    {
+      m_showStats = !m_showStats;
+      m_statsFrame = 0;
+    }
+    doneCurrent();
+  }
+  else
+  {
+    QOpenGLWidget::keyPressEvent(_event);
+  }
+  update();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,182 @@
+/// @file Trace.cpp
+/// @brief scoped timers recorded into per thread ring buffers and written as Chrome trace event JSON
+
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+struct TraceEvent
+{
+    const char *name;
+    std::uint64_t start;
+    std::uint64_t duration;
+};
+
+/// @brief the events of one thread, written by that thread and read when the trace is written
+struct TraceBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    /// @brief events ever recorded, the newest is at (recorded - 1) % capacity
+    std::size_t recorded = 0;
+    std::size_t threadId = 0;
+};
+
+std::atomic<bool> s_enabled{false};
+std::atomic<std::size_t> s_capacity{1u << 16};
+
+/// @brief every buffer ever created, kept after its thread exits so its events can still be written
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    std::string exitPath;
+};
+
+TraceRegistry &registry()
+{
+    // never destroyed so scopes and the exit dump can run during static destruction
+    static TraceRegistry *s_registry = new TraceRegistry;
+    return *s_registry;
+}
+
+TraceBuffer &threadBuffer()
+{
+    thread_local std::shared_ptr<TraceBuffer> t_buffer;
+    if (!t_buffer)
+    {
+        t_buffer = std::make_shared<TraceBuffer>();
+        t_buffer->events.resize(std::max<std::size_t>(s_capacity.load(std::memory_order_relaxed), 1));
+        TraceRegistry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        t_buffer->threadId = reg.buffers.size() + 1;
+        reg.buffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+}
+
+std::uint64_t nowNanoseconds() noexcept
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+void writeEscaped(std::ostream &_out, const char *_text)
+{
+    for (const char *c = _text; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            _out << '\\';
+        _out << *c;
+    }
+}
+
+void writeTraceAtExit()
+{
+    const std::string path = registry().exitPath;
+    if (!path.empty())
+        writeTraceFile(path);
+}
+} // end anonymous namespace
+
+void setTracingEnabled(bool _enabled) noexcept
+{
+    s_enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+bool isTracingEnabled() noexcept
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void setTraceCapacity(std::size_t _eventsPerThread) noexcept
+{
+    s_capacity.store(_eventsPerThread, std::memory_order_relaxed);
+}
+
+void clearTrace()
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->recorded = 0;
+    }
+}
+
+std::size_t writeTrace(std::ostream &_out)
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::size_t written = 0;
+    _out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        const std::size_t capacity = buffer->events.size();
+        const std::size_t count = std::min(buffer->recorded, capacity);
+        for (std::size_t i = buffer->recorded - count; i < buffer->recorded; ++i)
+        {
+            const TraceEvent &event = buffer->events[i % capacity];
+            _out << (written == 0 ? "\n" : ",\n") << "{\"name\":\"";
+            writeEscaped(_out, event.name);
+            // trace event times are microseconds
+            _out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":" << event.start / 1000
+                 << '.' << (event.start % 1000) / 100 << ",\"dur\":" << event.duration / 1000 << '.'
+                 << (event.duration % 1000) / 100 << '}';
+            ++written;
+        }
+    }
+    _out << "\n]}\n";
+    return written;
+}
+
+bool writeTraceFile(const std::string &_path)
+{
+    std::ofstream out(_path);
+    if (!out)
+        return false;
+    writeTrace(out);
+    return static_cast<bool>(out);
+}
+
+void dumpTraceAtExit(const std::string &_path)
+{
+    TraceRegistry &reg = registry();
+    bool registered = false;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        registered = !reg.exitPath.empty();
+        reg.exitPath = _path;
+    }
+    if (!registered)
+        std::atexit(writeTraceAtExit);
+    setTracingEnabled(true);
+}
+
+TraceScope::TraceScope(const char *_name) noexcept : m_name(isTracingEnabled() ? _name : nullptr)
+{
+    if (m_name != nullptr)
+        m_start = nowNanoseconds();
+}
+
+TraceScope::~TraceScope() noexcept
+{
+    if (m_name == nullptr)
+        return;
+    const std::uint64_t end = nowNanoseconds();
+    TraceBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events[buffer.recorded % buffer.events.size()] = {m_name, m_start, end - m_start};
+    ++buffer.recorded;
+}
@@ -0,0 +1,59 @@
+/// @file VertexUpload.cpp
+/// @brief streaming of vertex data into persistent GL buffers, counting of the bytes uploaded and of the draws issued
+
+#include "VertexUpload.h"
+#include "ngl/SimpleVAO.h"
+#include <atomic>
+
+namespace
+{
+std::atomic<std::size_t> s_uploadedBytes{0};
+std::atomic<std::size_t> s_drawCalls{0};
+std::atomic<std::size_t> s_drawVertices{0};
+} // end anonymous namespace
+
+void recordUpload(std::size_t _bytes) noexcept
+{
+    s_uploadedBytes.fetch_add(_bytes, std::memory_order_relaxed);
+}
+
+std::size_t takeUploadedBytes() noexcept
+{
+    return s_uploadedBytes.exchange(0, std::memory_order_relaxed);
+}
+
+void recordDraw(std::size_t _vertices) noexcept
+{
+    s_drawCalls.fetch_add(1, std::memory_order_relaxed);
+    s_drawVertices.fetch_add(_vertices, std::memory_order_relaxed);
+}
+
+DrawCounts takeDrawCounts() noexcept
+{
+    DrawCounts counts;
+    counts.calls = s_drawCalls.exchange(0, std::memory_order_relaxed);
+    counts.vertices = s_drawVertices.exchange(0, std::memory_order_relaxed);
+    return counts;
+}
+
+void streamPoints(ngl::AbstractVAO &_vao, std::size_t &io_capacity, const ngl::Vec3 *_points, std::size_t _count)
+{
+    _vao.setNumIndices(_count);
+    if (_count == 0)
+        return;
+
+    const std::size_t bytes = _count * sizeof(ngl::Vec3);
+    if (_count > io_capacity)
+    {
+        // setData replaces the buffer so the attribute has to point at the new one
+        _vao.setData(ngl::SimpleVAO::VertexData(bytes, _points[0].m_x, GL_DYNAMIC_DRAW));
+        _vao.setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
+        io_capacity = _count;
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, _vao.getBufferID());
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &_points[0].m_x);
+    }
+    recordUpload(bytes);
+}
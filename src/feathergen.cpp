@@ -0,0 +1,248 @@
+/// @file feathergen.cpp
+/// @brief headless batch generator, parameter files in and OBJ files out, no Qt or GL needed,
+/// the reads, generation and writes overlap in a BatchPipeline
+
+#include "BatchPipeline.h"
+#include "FeatherIO.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    /// @brief extension of the parameter files picked up from a directory
+    constexpr const char *s_paramsExtension = ".feather";
+
+    struct Options
+    {
+        std::vector<fs::path> inputs;
+        fs::path outputDir = ".";
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+        /// @brief feathers per parameter file, variant k uses the file's seed + k
+        unsigned int variants = 1;
+        /// @brief items per pipeline queue, 0 for the BatchSettings default
+        unsigned int queueCapacity = 0;
+        bool write = true;
+        bool stats = false;
+        bool outlines = true;
+    };
+
+    void usage(std::ostream &_out)
+    {
+        _out << "usage: feathergen [options] <file.feather | directory>...\n"
+                "  -o <dir>         write the OBJ files here (default .)\n"
+                "  -j <threads>     generation threads (default all cores)\n"
+                "  -n <variants>    feathers per parameter file, seeds seed .. seed + n - 1\n"
+                "  -q <items>       capacity of each pipeline queue (default twice the threads)\n"
+                "  --stats          print the occupancy of every pipeline stage and queue\n"
+                "  --no-write       generate only, to measure throughput\n"
+                "  --barbs-only     leave the outlines and template barbs out of the OBJ\n"
+                "  --defaults       print a parameter file with every default and exit\n"
+                "FEATHER_TRACE=trace.json records a Chrome trace of the run\n";
+    }
+
+    /// @brief parse a positive count, false if _text is not one
+    bool parseCount(const char *_text, unsigned int &o_value)
+    {
+        char *end = nullptr;
+        const long value = std::strtol(_text, &end, 10);
+        if (end == _text || *end != '\0' || value < 1)
+        {
+            return false;
+        }
+        o_value = static_cast<unsigned int>(value);
+        return true;
+    }
+
+    /// @return false when feathergen should exit straight away with o_exitCode
+    bool parseArguments(int _argc, char **_argv, Options &o_options, int &o_exitCode)
+    {
+        o_exitCode = EXIT_SUCCESS;
+        for (int i = 1; i < _argc; ++i)
+        {
+            const std::string arg = _argv[i];
+            const bool hasValue = i + 1 < _argc;
+            if (arg == "-h" || arg == "--help")
+            {
+                usage(std::cout);
+                return false;
+            }
+            else if (arg == "--defaults")
+            {
+                writeFeatherParams(std::cout, FeatherParams());
+                return false;
+            }
+            else if (arg == "-o" && hasValue)
+            {
+                o_options.outputDir = _argv[++i];
+            }
+            else if (arg == "-j" && hasValue)
+            {
+                if (!parseCount(_argv[++i], o_options.threads))
+                {
+                    std::cerr << "feathergen: -j needs a positive thread count\n";
+                    o_exitCode = 2;
+                    return false;
+                }
+            }
+            else if (arg == "-n" && hasValue)
+            {
+                if (!parseCount(_argv[++i], o_options.variants))
+                {
+                    std::cerr << "feathergen: -n needs a positive count\n";
+                    o_exitCode = 2;
+                    return false;
+                }
+            }
+            else if (arg == "-q" && hasValue)
+            {
+                if (!parseCount(_argv[++i], o_options.queueCapacity))
+                {
+                    std::cerr << "feathergen: -q needs a positive capacity\n";
+                    o_exitCode = 2;
+                    return false;
+                }
+            }
+            else if (arg == "--stats")
+            {
+                o_options.stats = true;
+            }
+            else if (arg == "--no-write")
+            {
+                o_options.write = false;
+            }
+            else if (arg == "--barbs-only")
+            {
+                o_options.outlines = false;
+            }
+            else if (!arg.empty() && arg[0] == '-')
+            {
+                std::cerr << "feathergen: unknown option " << arg << '\n';
+                usage(std::cerr);
+                o_exitCode = 2;
+                return false;
+            }
+            else
+            {
+                o_options.inputs.emplace_back(arg);
+            }
+        }
+        if (o_options.inputs.empty())
+        {
+            usage(std::cerr);
+            o_exitCode = 2;
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief expand directories into their parameter files, sorted so runs are repeatable
+    std::vector<fs::path> collectFiles(const std::vector<fs::path> &_inputs)
+    {
+        std::vector<fs::path> files;
+        for (const fs::path &input : _inputs)
+        {
+            std::error_code error;
+            if (!fs::is_directory(input, error))
+            {
+                files.push_back(input);
+                continue;
+            }
+            std::vector<fs::path> found;
+            for (const auto &entry : fs::directory_iterator(input, error))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == s_paramsExtension)
+                {
+                    found.push_back(entry.path());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        return files;
+    }
+} // end anonymous namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    int exitCode = EXIT_SUCCESS;
+    if (!parseArguments(argc, argv, options, exitCode))
+    {
+        return exitCode;
+    }
+    if (const char *tracePath = std::getenv("FEATHER_TRACE"))
+    {
+        dumpTraceAtExit(tracePath);
+    }
+    const std::vector<fs::path> files = collectFiles(options.inputs);
+    if (options.write)
+    {
+        std::error_code error;
+        fs::create_directories(options.outputDir, error);
+        if (error)
+        {
+            std::cerr << "feathergen: cannot create " << options.outputDir << ": " << error.message() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    BatchSettings settings;
+    settings.workers = options.threads;
+    settings.queueCapacity = options.queueCapacity;
+    settings.variants = options.variants;
+    settings.serialise = options.write;
+    settings.outlines = options.outlines;
+    // runs on the pipeline's writer thread in batch order
+    auto sink = [&options](const BatchResult &_result)
+    {
+        if (!_result.error.empty())
+        {
+            std::cerr << "feathergen: " << _result.error << '\n';
+            return false;
+        }
+        if (!options.write)
+        {
+            return true;
+        }
+        std::ofstream out(options.outputDir / (_result.name + ".obj"), std::ios::binary);
+        out.write(_result.obj.data(), static_cast<std::streamsize>(_result.obj.size()));
+        if (!out)
+        {
+            std::cerr << "feathergen: failed writing " << _result.name << ".obj\n";
+            return false;
+        }
+        return true;
+    };
+    const BatchStats stats = runBatchPipeline(files, settings, sink);
+
+    std::cout << "feathergen: " << stats.feathers << " feathers from " << files.size() << " files in "
+              << stats.wallMs / 1000.0 << " s on " << stats.generate.threads << " threads, "
+              << stats.feathersPerSecond() << " feathers/sec";
+    if (options.write)
+    {
+        std::cout << ", " << stats.objBytes << " bytes written to " << options.outputDir.string();
+    }
+    std::cout << '\n';
+    if (options.stats)
+    {
+        for (const std::string &line : stats.lines())
+        {
+            std::cout << line << '\n';
+        }
+    }
+    if (stats.failed != 0)
+    {
+        std::cerr << "feathergen: " << stats.failed << " feathers failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -3,10 +3,17 @@ basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwin
 ****************************************************************************/
 #include <QApplication>
 #include <iostream>
+#include <cstdlib>
+#include "Trace.h"
 #include "mainwindow.h"
 
 int main(int argc, char **argv)
 {
+  // FEATHER_TRACE=trace.json records a Chrome trace of the session
+  if (const char *tracePath = std::getenv("FEATHER_TRACE"))
+  {
+    dumpTraceAtExit(tracePath);
+  }
   // create an OpenGL format specifier
   QSurfaceFormat format;
   // set the number of samples for multisampling
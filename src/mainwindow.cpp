@@ -1,6 +1,9 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QGridLayout>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -110,6 +113,14 @@ void MainWindow::setupConnections()
     
     // Connect outline controls
     connect(ui->symmetrical, &QCheckBox::toggled, this, &MainWindow::onSymmetricalChanged);
+
+    // Every edit posts a snapshot, the generator drops the ones it has not started yet
+    for (auto *spin : findChildren<QSpinBox *>())
+        connect(spin, qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::postParams);
+    for (auto *spin : findChildren<QDoubleSpinBox *>())
+        connect(spin, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &MainWindow::postParams);
+    for (auto *check : findChildren<QCheckBox *>())
+        connect(check, &QCheckBox::toggled, this, &MainWindow::postParams);
 }
 
 void MainWindow::onResetClicked()
@@ -180,11 +191,20 @@ void MainWindow::onResetClicked()
 
 void MainWindow::onRenderClicked()
 {
-    updateRachis();
-    updateOutlines();
-    updateBarbs();
-    updateAllFeather();
-    m_gl->update();
+    postParams();
+}
+
+void MainWindow::postParams()
+{
+    if (!m_gl) return;
+
+    FeatherParams params;
+    updateRachis(params);
+    updateOutlines(params);
+    updateBarbs(params);
+    updateAllFeather(params);
+    // NGLScene repaints itself once the worker has built it
+    m_gl->requestFeather(params);
 }
 
 void MainWindow::onTabChanged(int index)
@@ -210,7 +230,7 @@ void MainWindow::onTabChanged(int index)
     }
 }
 
-void MainWindow::updateRachis()
+void MainWindow::updateRachis(FeatherParams &o_params) const
 {
     // Get values from UI spin boxes
     ngl::Vec3 p0(ui->P0_X->value(), ui->P0_Y->value(), ui->P0_Z->value());
@@ -220,16 +240,15 @@ void MainWindow::updateRachis()
     
     int sampleNum = ui->sample->value();
 
-    if (m_gl) {
-        m_gl->getFeather()->setSampleNum(sampleNum);
-        m_gl->getFeather()->setRachisControlPoints(p0, p1, p2, p3);
-    }
+    o_params.sampleNum = static_cast<unsigned int>(sampleNum);
+    o_params.rachisP0 = p0;
+    o_params.rachisP1 = p1;
+    o_params.rachisP2 = p2;
+    o_params.rachisP3 = p3;
 }
 
-void MainWindow::updateOutlines()
+void MainWindow::updateOutlines(FeatherParams &o_params) const
 {
-    if (!m_gl) return;
-    
     // Get outline control points from UI
     ngl::Vec3 p1(ui->O_P1_X->value(), ui->O_P1_Y->value(), ui->O_P1_Z->value());
     ngl::Vec3 p2(ui->O_P2_X->value(), ui->O_P2_Y->value(), ui->O_P2_Z->value());
@@ -237,25 +256,19 @@ void MainWindow::updateOutlines()
     
     // Get F0 factor from UI
     double f0 = ui->f0->value();
-    m_gl->getFeather()->setF0(f0);
-    
-    bool symmetric = ui->symmetrical->isChecked();
-    
-    if (symmetric) {
-        // Use symmetrical outline control points
-        m_gl->getFeather()->setSymmetricOutlineControlPoints(p1, p2, p3);
-    } else {
-        // Use separate control points for left and right
-        ngl::Vec3 rightP1(ui->O_P4_X->value(), ui->O_P4_Y->value(), ui->O_P4_Z->value());
-        ngl::Vec3 rightP2(ui->O_P5_X->value(), ui->O_P5_Y->value(), ui->O_P5_Z->value());
-        m_gl->getFeather()->setOutlineControlPoints(p1, p2, rightP1, rightP2, p3);
-    }
+    o_params.f0 = f0;
+    
+    // the right points are mirrored from the left ones when symmetric
+    o_params.outlineSymmetric = ui->symmetrical->isChecked();
+    o_params.outlineP1 = p1;
+    o_params.outlineP2 = p2;
+    o_params.outlineP3 = p3;
+    o_params.rightOutlineP1 = ngl::Vec3(ui->O_P4_X->value(), ui->O_P4_Y->value(), ui->O_P4_Z->value());
+    o_params.rightOutlineP2 = ngl::Vec3(ui->O_P5_X->value(), ui->O_P5_Y->value(), ui->O_P5_Z->value());
 }
 
-void MainWindow::updateBarbs()
+void MainWindow::updateBarbs(FeatherParams &o_params) const
 {
-    if (!m_gl) return;
-    
     // Get barb parameters from UI
     double fb = ui->fb->value();
     int lod = ui->spinBox->value();
@@ -267,16 +280,18 @@ void MainWindow::updateBarbs()
     double p2YFactor = ui->barb_p2_y_f->value();
     
     // Update feather barb parameters
-    m_gl->getFeather()->setFb(fb);
-    m_gl->getFeather()->setBarbLOD(lod);
-    m_gl->getFeather()->setBarbsOutlineFactor(leftEndFactor, rightEndFactor);
-    m_gl->getFeather()->setBarbControlFactors(p1XFactor, p1YFactor, p2XFactor, p2YFactor);
+    o_params.fb = fb;
+    o_params.barbLOD = static_cast<unsigned int>(lod);
+    o_params.leftBarbOutlineFactor = leftEndFactor;
+    o_params.rightBarbOutlineFactor = rightEndFactor;
+    o_params.p1XFactor = p1XFactor;
+    o_params.p1YFactor = p1YFactor;
+    o_params.p2XFactor = p2XFactor;
+    o_params.p2YFactor = p2YFactor;
 }
 
-void MainWindow::updateAllFeather()
+void MainWindow::updateAllFeather(FeatherParams &o_params) const
 {
-    if (!m_gl) return;
-    
     // Get "All" tab parameters from UI
     int barbNum = ui->barbnum->value();
     int barbLOD = ui->barblod->value();
@@ -286,11 +301,12 @@ void MainWindow::updateAllFeather()
     double mappingEnd = ui->m_outlineMappingEnd->value();
     
     // Update feather parameters for full feather generation
-    m_gl->getFeather()->setNumBarbs(barbNum);
-    m_gl->getFeather()->setBarbLOD(barbLOD);
-    m_gl->getFeather()->setShowOutlines(showOutlines);
-    m_gl->getFeather()->setFn(tipFactor);
-    m_gl->getFeather()->setOutlineMappingRange(mappingStart, mappingEnd);
+    o_params.numBarbs = static_cast<unsigned int>(barbNum);
+    o_params.barbLOD = static_cast<unsigned int>(barbLOD);
+    o_params.showOutlines = showOutlines;
+    o_params.fn = tipFactor;
+    o_params.outlineMappingStart = mappingStart;
+    o_params.outlineMappingEnd = mappingEnd;
 }
 
 void MainWindow::onSymmetricalChanged(bool checked)
@@ -298,9 +314,5 @@ void MainWindow::onSymmetricalChanged(bool checked)
     // Enable/disable right outline controls based on symmetrical checkbox
     ui->groupBox_8->setEnabled(!checked);  // R_P1 group
     ui->groupBox_9->setEnabled(!checked);  // R_P2 group
-    
-    // Update feather symmetry setting (only if feather object exists)
-    if (m_gl && m_gl->getFeather()) {
-        m_gl->getFeather()->setOutlineSymmetric(checked);
-    }
+    // the symmetry itself is part of the snapshot postParams sends
 }
@@ -0,0 +1,234 @@
+#include <benchmark/benchmark.h>
+#include "../include/Curve.h"
+#include "../include/Feather.h"
+#include "../include/FeatherGeometry.h"
+#include "ngl/Vec3.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+//============================================================================
+// Allocation counting, every benchmark reports bytes and allocations per iteration
+//============================================================================
+
+namespace {
+std::atomic<std::size_t> g_allocBytes{0};
+std::atomic<std::size_t> g_allocCount{0};
+
+void* countedAlloc(std::size_t size) {
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* countedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants a multiple of the alignment
+    const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    if (void* p = std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+/// Counts the allocations made between construction and report, on every thread
+/// including OpenMP's, so only single threaded benchmarks can report them
+class AllocationCounter {
+public:
+    AllocationCounter()
+        : m_bytes(g_allocBytes.load(std::memory_order_relaxed)),
+          m_count(g_allocCount.load(std::memory_order_relaxed)) {}
+
+    void report(benchmark::State& state) const {
+        // the other benchmark threads' allocations would land in every thread's count
+        if (state.threads() != 1) {
+            return;
+        }
+        const double bytes = static_cast<double>(g_allocBytes.load(std::memory_order_relaxed) - m_bytes);
+        const double count = static_cast<double>(g_allocCount.load(std::memory_order_relaxed) - m_count);
+        state.counters["bytes_alloc"] = benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+        state.counters["allocs"] = benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    std::size_t m_bytes;
+    std::size_t m_count;
+};
+
+/// The default feather of the UI
+void setupFeather(Feather& feather, unsigned int numBarbs, unsigned int lod) {
+    feather.setNumBarbs(numBarbs);
+    feather.setBarbLOD(lod);
+    feather.generate();
+}
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+//============================================================================
+// Curve evaluation
+//============================================================================
+
+/// Evaluate a curve of range(0) control points at range(1) parameters
+static void BM_CurveEvaluate(benchmark::State& state) {
+    const auto numCPs = static_cast<size_t>(state.range(0));
+    const auto lod = static_cast<size_t>(state.range(1));
+    std::vector<ngl::Vec3> cps;
+    for (size_t i = 0; i < numCPs; ++i) {
+        cps.emplace_back(static_cast<ngl::Real>(i), static_cast<ngl::Real>(i % 3), 0.0f);
+    }
+    BezierCurve curve(cps);
+    std::vector<ngl::Real> ts(lod);
+    for (size_t s = 0; s < lod; ++s) {
+        ts[s] = static_cast<ngl::Real>(s) / static_cast<ngl::Real>(lod);
+    }
+    std::vector<ngl::Vec3> points(lod);
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        curve.evaluate(ts, points);
+        benchmark::DoNotOptimize(points.data());
+        benchmark::ClobberMemory();
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lod));
+}
+BENCHMARK(BM_CurveEvaluate)->ArgNames({"cps", "lod"})->ArgsProduct({{2, 4, 8, 16}, {16, 200, 1000}});
+
+/// Sample a cubic the way the renderer does, the cache is invalidated every iteration
+static void BM_CurveTessellate(benchmark::State& state) {
+    const auto lod = static_cast<unsigned int>(state.range(0));
+    BezierCurve curve({ngl::Vec3(0.0f, 0.0f, 0.0f), ngl::Vec3(0.3f, 2.0f, 0.0f),
+                       ngl::Vec3(0.5f, 4.0f, 0.0f), ngl::Vec3(0.2f, 9.5f, 0.0f)});
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        curve.setLOD(lod + 1);
+        curve.setLOD(lod);
+        benchmark::DoNotOptimize(curve.getSampleView().data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lod));
+}
+BENCHMARK(BM_CurveTessellate)->ArgName("lod")->Arg(20)->Arg(200)->Arg(2000);
+
+//============================================================================
+// Feather generation
+//============================================================================
+
+static void BM_GenerateSingleBarb(benchmark::State& state) {
+    Feather feather;
+    setupFeather(feather, 10, static_cast<unsigned int>(state.range(0)));
+    const ngl::Vec3 p0(0.2f, 4.0f, 0.0f);
+    const ngl::Vec3 p3(-1.5f, 6.0f, 0.0f);
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        auto barb = feather.GenerateSingleBarb(p0, p3, 0.3f, 1.0f, 0.1f, 0.0f, true);
+        benchmark::DoNotOptimize(barb->getSampleView().data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateSingleBarb)->ArgName("lod")->Arg(20)->Arg(100);
+
+/// range(0) barbs per side at LOD 20 on range(1) threads
+static void BM_GenerateAllBarbs(benchmark::State& state) {
+    const auto numBarbs = static_cast<unsigned int>(state.range(0));
+    Feather feather;
+    feather.setNumThreads(static_cast<unsigned int>(state.range(1)));
+    setupFeather(feather, numBarbs, 20);
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        feather.generateAllBarbs();
+        benchmark::DoNotOptimize(feather.getBarbs().samples().data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * 2 * static_cast<int64_t>(numBarbs));
+}
+
+/// Small feathers on one thread, then the scaling curve over 1, 2, 4 .. every core at 10k+ barbs
+static void allBarbsArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"barbs", "threads"});
+    bench->Args({100, 1})->Args({1000, 1});
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int barbs : {10000, 50000}) {
+        for (int threads = 1; threads < cores; threads *= 2) {
+            bench->Args({barbs, threads});
+        }
+        bench->Args({barbs, cores});
+    }
+}
+BENCHMARK(BM_GenerateAllBarbs)->Apply(allBarbsArgs)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_GenerateOutlines(benchmark::State& state) {
+    Feather feather;
+    setupFeather(feather, 100, 20);
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        feather.generateOutlines();
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateOutlines);
+
+/// Everything Feather::generate does for a new feather of range(0) barbs, reported as feathers per second
+static void BM_GenerateFeather(benchmark::State& state) {
+    const auto numBarbs = static_cast<unsigned int>(state.range(0));
+    Feather feather;
+    setupFeather(feather, numBarbs, 20);
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        feather.markDirty(FeatherStage::RACHIS);
+        feather.generate();
+        benchmark::DoNotOptimize(feather.getBarbs().samples().data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateFeather)->ArgName("barbs")->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/// generateFeather of range(0) barbs into a reused arena, one feather per seed on every thread,
+/// allocations are reported for the single threaded run
+static void BM_GenerateFeatherArena(benchmark::State& state) {
+    FeatherParams params;
+    params.numBarbs = static_cast<unsigned int>(state.range(0));
+    params.barbJitter = 0.5f;
+    Arena arena;
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        arena.reset();
+        ++params.seed;
+        benchmark::DoNotOptimize(generateFeather(params, arena).barbSamples.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateFeatherArena)->ArgName("barbs")->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond)
+    ->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();